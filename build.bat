@@ -9,7 +9,7 @@ if "%GLSLC_EXE%"=="" set GLSLC_EXE=glslc.exe
 
 set CFLAGS=/D_CRT_SECURE_NO_WARNINGS /I"%VULKAN_SDK%\Include" /I"%SDL_INCLUDE%" /W4 %OPTIMIZE%
 set LFLAGS=/LIBPATH:"%VULKAN_SDK%\Lib" /LIBPATH:"%SDL_LIB%" vulkan-1.lib SDL2.lib
-set SOURCES=src\3d.c src\noise.c src\planet.c src\renderer.c src\transfer_buffer.c simplex\simplex.c
+set SOURCES=src\3d.c src\noise.c src\planet.c src\renderer.c src\staging_ring.c src\thread_pool.c simplex\simplex.c
 
 @echo on
 
@@ -17,6 +17,8 @@ if not exist bin mkdir bin
 if not exist build mkdir build
 
 %GLSLC_EXE% shaders\planet.vert -o build\planet.vert.spv
+%GLSLC_EXE% shaders\planet_packed.vert -o build\planet_packed.vert.spv
+%GLSLC_EXE% shaders\planet_heights.vert -o build\planet_heights.vert.spv
 %GLSLC_EXE% shaders\planet.frag -o build\planet.frag.spv
 %CL_EXE% %CFLAGS% /TC /std:c11 /c src\main.c /Fo:build\
 %CL_EXE% %CFLAGS% /TC /std:c11 /c %SOURCES% /Fo:build\
@@ -0,0 +1,72 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 0) out vec3 f_normal;
+layout (location = 1) out vec3 f_color;
+
+layout (binding=0) uniform ubo {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float radius_min;
+    float radius_max;
+};
+
+// see struct planet_mesh
+layout (std430, binding=1) readonly buffer radii_buffer {
+    float radii[];
+};
+layout (std430, binding=2) readonly buffer directions_x_buffer {
+    float directions_x[];
+};
+layout (std430, binding=3) readonly buffer directions_y_buffer {
+    float directions_y[];
+};
+layout (std430, binding=4) readonly buffer directions_z_buffer {
+    float directions_z[];
+};
+layout (std430, binding=5) readonly buffer neighbours_buffer {
+    uint neighbours[];
+};
+
+// PLANET_MAX_NEIGHBOURS
+const uint MAX_NEIGHBOURS = 6;
+
+#include "planet_color.glsl"
+
+vec3
+vertex_position(uint vertex)
+{
+    vec3 direction = vec3(
+        directions_x[vertex], directions_y[vertex], directions_z[vertex]
+    );
+    return direction * radii[vertex];
+}
+
+void
+main() 
+{
+    uint vertex = uint(gl_VertexIndex);
+    vec3 position = vertex_position(vertex);
+
+    // area weighted normals of the triangles around the vertex, consecutive
+    // neighbours span one triangle each and repeated ones add nothing
+    vec3 normal = vec3(0.0f);
+    uint first = vertex * MAX_NEIGHBOURS;
+    vec3 previous = vertex_position(neighbours[first + MAX_NEIGHBOURS - 1]) - position;
+    for (uint i = 0; i < MAX_NEIGHBOURS; i++) {
+        vec3 current = vertex_position(neighbours[first + i]) - position;
+        normal += cross(previous, current);
+        previous = current;
+    }
+    normal = normalize(normal);
+
+    vec4 world_position = model*vec4(position, 1.0f);
+    vec4 world_normal = model*vec4(normal, 0.0f);
+
+    f_color = planet_color(position, normal);
+
+    f_normal = normalize(world_normal.xyz);
+
+    gl_Position = proj * view * world_position;
+}
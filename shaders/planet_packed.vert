@@ -0,0 +1,49 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// see struct planet_packed_vertex
+layout (location = 0) in vec2 packed_direction;
+layout (location = 1) in float packed_radius;
+layout (location = 2) in vec2 packed_normal;
+
+layout (location = 0) out vec3 f_normal;
+layout (location = 1) out vec3 f_color;
+
+layout (binding=0) uniform ubo {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    float radius_min;
+    float radius_max;
+};
+
+#include "planet_color.glsl"
+
+// inverse of vec3_octahedral_encode
+vec3
+octahedral_decode(vec2 encoded)
+{
+    vec3 v = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    if (v.z < 0.0f) {
+        vec2 signs = mix(vec2(-1.0f), vec2(1.0f), greaterThanEqual(v.xy, vec2(0.0f)));
+        v.xy = (1.0f - abs(v.yx)) * signs;
+    }
+    return normalize(v);
+}
+
+void
+main() 
+{
+    float radius = mix(radius_min, radius_max, packed_radius);
+    vec3 position = octahedral_decode(packed_direction) * radius;
+    vec3 normal = octahedral_decode(packed_normal);
+
+    vec4 world_position = model*vec4(position, 1.0f);
+    vec4 world_normal = model*vec4(normal, 0.0f);
+
+    f_color = planet_color(position, normal);
+
+    f_normal = normalize(world_normal.xyz);
+
+    gl_Position = proj * view * world_position;
+}
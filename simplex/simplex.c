@@ -27,9 +27,26 @@
 #define NORM_CONSTANT_3D (103.0)
 #define DEFAULT_SEED (0LL)
 
+struct osn_context;
+
+typedef void (*sample3_batch_fn)(const struct osn_context *ctx, const double *x, const double *y, const double *z, double *out,
+	double *gx, double *gy, double *gz, size_t count);
+typedef void (*sample3f_batch_fn)(const struct osn_context *ctx, const float *x, const float *y, const float *z, float *out,
+	float *gx, float *gy, float *gz, size_t count);
+
 struct osn_context {
 	int16_t *perm;
 	int16_t *permGradIndex3D;
+
+	/* Batch sampling tables, the gradient for each permuted index is resolved
+	   up front so a lattice point costs two permutation lookups and one
+	   gradient lookup, all 32 bit or wider so they can be gathered. */
+	int32_t permBatch[256];
+	double gradDouble3D[3][256];
+	float gradFloat3D[3][256];
+	enum simplex_precision precision;
+	sample3_batch_fn sample3Batch;
+	sample3f_batch_fn sample3fBatch;
 };
 
 #define ARRAYSIZE(x) (sizeof((x)) / sizeof((x)[0]))
@@ -66,12 +83,20 @@ static INLINE int fastFloor(double x) {
 	return x < xi ? xi - 1 : xi;
 }
 
+static sample3_batch_fn select_sample3_batch(void);
+static sample3f_batch_fn select_sample3f_batch(void);
+
 /*	
  * Initializes using a permutation array generated from a 64-bit seed.
  * Generates a proper permutation (i.e. doesn't merely perform N successive pair
  * swaps on a base array).  Uses a simple 64-bit LCG.
  */
 struct osn_context* simplex_context_create(int64_t seed)
+{
+	return simplex_context_create_precision(seed, SIMPLEX_PRECISION_DOUBLE);
+}
+
+struct osn_context* simplex_context_create_precision(int64_t seed, enum simplex_precision precision)
 {
     struct osn_context* ctx;
     ctx = malloc(sizeof *ctx);
@@ -106,6 +131,17 @@ struct osn_context* simplex_context_create(int64_t seed)
 		source[r] = source[i];
 	}
 
+	for (int i = 0; i < 256; i++) {
+		ctx->permBatch[i] = ctx->perm[i];
+		for (int axis = 0; axis < 3; axis++) {
+			ctx->gradDouble3D[axis][i] = gradients3D[ctx->permGradIndex3D[i] + axis];
+			ctx->gradFloat3D[axis][i] = gradients3D[ctx->permGradIndex3D[i] + axis];
+		}
+	}
+	ctx->precision = precision;
+	ctx->sample3Batch = select_sample3_batch();
+	ctx->sample3fBatch = select_sample3f_batch();
+
     return ctx;
 }
 
@@ -690,3 +726,177 @@ double simplex_sample3(struct osn_context* ctx, double x, double y, double z)
 	
 	return value / NORM_CONSTANT_3D;
 }
+
+/*
+ * Batched 3D OpenSimplex
+ *
+ * The same algorithm as simplex_sample3 restructured so that it has no data
+ * dependent branches: every lane evaluates the 8 corners of its rhombohedral
+ * super-cell (masked down to the ones its region would have used) plus the
+ * two extra vertices, which are chosen with selects and expressed as integer
+ * offsets from the super-cell origin. A block of SIMPLEX_BATCH_LANES points
+ * is then a straight line loop the compiler can vectorize, and it is compiled
+ * once per instruction set with the best one picked at context creation.
+ */
+
+#if defined(__GNUC__)
+	#define BATCH_INLINE __attribute__((always_inline)) INLINE
+#elif defined(_MSC_VER)
+	#define BATCH_INLINE __forceinline
+#else
+	#define BATCH_INLINE INLINE
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SIMPLEX_BATCH_X86
+#endif
+
+/*
+ * GCC won't if-convert the lane loop while it has to assume a floating point
+ * comparison might trap, none of the inputs are signaling NaNs.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC push_options
+	#pragma GCC optimize("no-trapping-math")
+#endif
+
+#define BATCH_REAL double
+#define BATCH_FABS fabs
+#define BATCH_GRADS gradDouble3D
+#define BATCH_SUFFIX _double
+#include "simplex_batch.inl"
+#undef BATCH_REAL
+#undef BATCH_FABS
+#undef BATCH_GRADS
+#undef BATCH_SUFFIX
+
+/*
+ * Single precision halves the width of every lane, so each vector holds
+ * twice as many points and the tables take half the cache.
+ */
+#define BATCH_REAL float
+#define BATCH_FABS fabsf
+#define BATCH_GRADS gradFloat3D
+#define BATCH_SUFFIX _float
+#include "simplex_batch.inl"
+#undef BATCH_REAL
+#undef BATCH_FABS
+#undef BATCH_GRADS
+#undef BATCH_SUFFIX
+
+
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC pop_options
+#endif
+
+/*
+ * NEON is part of the aarch64 baseline so the generic kernel already uses it
+ * there, other compilers/architectures get whatever their default flags allow.
+ */
+static sample3_batch_fn select_sample3_batch(void)
+{
+#ifdef SIMPLEX_BATCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return sample3_batch_avx2_double;
+	if (__builtin_cpu_supports("sse4.1"))
+		return sample3_batch_sse41_double;
+#endif
+	return sample3_batch_generic_double;
+}
+
+static sample3f_batch_fn select_sample3f_batch(void)
+{
+#ifdef SIMPLEX_BATCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return sample3_batch_avx2_float;
+	if (__builtin_cpu_supports("sse4.1"))
+		return sample3_batch_sse41_float;
+#endif
+	return sample3_batch_generic_float;
+}
+
+/*
+ * Points given in the other precision to the context's are converted a
+ * chunk at a time on the stack.
+ */
+#define CONVERT_CHUNK (SIMPLEX_BATCH_LANES * 8)
+
+static void sample3_batch(struct osn_context *ctx, const double *x, const double *y, const double *z, double *out,
+	double *gx, double *gy, double *gz, size_t count)
+{
+	float xf[CONVERT_CHUNK], yf[CONVERT_CHUNK], zf[CONVERT_CHUNK], of[CONVERT_CHUNK];
+	float gxf[CONVERT_CHUNK], gyf[CONVERT_CHUNK], gzf[CONVERT_CHUNK];
+
+	if (ctx->precision == SIMPLEX_PRECISION_DOUBLE) {
+		ctx->sample3Batch(ctx, x, y, z, out, gx, gy, gz, count);
+		return;
+	}
+	for (size_t begin = 0; begin < count; begin += CONVERT_CHUNK) {
+		size_t size = count - begin < CONVERT_CHUNK ? count - begin : CONVERT_CHUNK;
+		for (size_t i = 0; i < size; i++) {
+			xf[i] = (float) x[begin + i];
+			yf[i] = (float) y[begin + i];
+			zf[i] = (float) z[begin + i];
+		}
+		ctx->sample3fBatch(ctx, xf, yf, zf, of, gx ? gxf : NULL, gyf, gzf, size);
+		for (size_t i = 0; i < size; i++)
+			out[begin + i] = of[i];
+		for (size_t i = 0; gx && i < size; i++) {
+			gx[begin + i] = gxf[i];
+			gy[begin + i] = gyf[i];
+			gz[begin + i] = gzf[i];
+		}
+	}
+}
+
+static void sample3f_batch(struct osn_context *ctx, const float *x, const float *y, const float *z, float *out,
+	float *gx, float *gy, float *gz, size_t count)
+{
+	double xd[CONVERT_CHUNK], yd[CONVERT_CHUNK], zd[CONVERT_CHUNK], od[CONVERT_CHUNK];
+	double gxd[CONVERT_CHUNK], gyd[CONVERT_CHUNK], gzd[CONVERT_CHUNK];
+
+	if (ctx->precision == SIMPLEX_PRECISION_FLOAT) {
+		ctx->sample3fBatch(ctx, x, y, z, out, gx, gy, gz, count);
+		return;
+	}
+	for (size_t begin = 0; begin < count; begin += CONVERT_CHUNK) {
+		size_t size = count - begin < CONVERT_CHUNK ? count - begin : CONVERT_CHUNK;
+		for (size_t i = 0; i < size; i++) {
+			xd[i] = x[begin + i];
+			yd[i] = y[begin + i];
+			zd[i] = z[begin + i];
+		}
+		ctx->sample3Batch(ctx, xd, yd, zd, od, gx ? gxd : NULL, gyd, gzd, size);
+		for (size_t i = 0; i < size; i++)
+			out[begin + i] = (float) od[i];
+		for (size_t i = 0; gx && i < size; i++) {
+			gx[begin + i] = (float) gxd[i];
+			gy[begin + i] = (float) gyd[i];
+			gz[begin + i] = (float) gzd[i];
+		}
+	}
+}
+
+void simplex_sample3_batch(struct osn_context *ctx, const double *x, const double *y, const double *z, double *out, size_t count)
+{
+	sample3_batch(ctx, x, y, z, out, NULL, NULL, NULL, count);
+}
+
+void simplex_sample3f_batch(struct osn_context *ctx, const float *x, const float *y, const float *z, float *out, size_t count)
+{
+	sample3f_batch(ctx, x, y, z, out, NULL, NULL, NULL, count);
+}
+
+void simplex_sample3_batch_gradient(struct osn_context *ctx, const double *x, const double *y, const double *z, double *out,
+	double *gx, double *gy, double *gz, size_t count)
+{
+	sample3_batch(ctx, x, y, z, out, gx, gy, gz, count);
+}
+
+void simplex_sample3f_batch_gradient(struct osn_context *ctx, const float *x, const float *y, const float *z, float *out,
+	float *gx, float *gy, float *gz, size_t count)
+{
+	sample3f_batch(ctx, x, y, z, out, gx, gy, gz, count);
+}
@@ -31,16 +31,69 @@
 	#define INLINE
 #endif
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 	extern "C" {
 #endif
 
+/*
+ * simplex_sample3_batch processes points in blocks of this many lanes, counts
+ * that aren't a multiple of it are padded internally.
+ */
+#define SIMPLEX_BATCH_LANES 8
+
+/*
+ * The double batch sampler sums contributions in a different order to
+ * simplex_sample3, results agree to within this absolute difference.
+ */
+#define SIMPLEX_BATCH_TOLERANCE 1e-12
+
+/*
+ * Precision the batch samplers compute in. Float halves register and table
+ * size so twice as many points fit in a vector, results drift from the double
+ * path by up to SIMPLEX_FLOAT_TOLERANCE for coordinates of magnitude up to
+ * about 100, growing with distance from the origin as float loses fraction
+ * bits. simplex_sample3 always uses double.
+ */
+enum simplex_precision {
+	SIMPLEX_PRECISION_DOUBLE,
+	SIMPLEX_PRECISION_FLOAT
+};
+
+#define SIMPLEX_FLOAT_TOLERANCE 1e-4
+
 typedef struct osn_context* SimplexContext;
 
+/* simplex_context_create uses SIMPLEX_PRECISION_DOUBLE */
 SimplexContext simplex_context_create(int64_t seed);
+SimplexContext simplex_context_create_precision(int64_t seed, enum simplex_precision precision);
 void simplex_context_destroy(SimplexContext);
 double simplex_sample3(SimplexContext, double x, double y, double z);
 
+/*
+ * Samples count points given as separate x, y and z arrays into out. Uses
+ * branch free code vectorized for the best instruction set available at
+ * runtime (AVX2 or SSE4.1 on x86, NEON on aarch64) with a portable fallback.
+ */
+void simplex_sample3_batch(SimplexContext, const double *x, const double *y, const double *z, double *out, size_t count);
+
+/*
+ * As simplex_sample3_batch for float points, which is the cheaper entry point
+ * when the context was created with SIMPLEX_PRECISION_FLOAT. Either function
+ * converts points given in the other precision.
+ */
+void simplex_sample3f_batch(SimplexContext, const float *x, const float *y, const float *z, float *out, size_t count);
+
+/*
+ * As the batch samplers above, also writing the analytic partial derivatives
+ * of the noise with respect to x, y and z to gx, gy and gz.
+ */
+void simplex_sample3_batch_gradient(SimplexContext, const double *x, const double *y, const double *z, double *out,
+	double *gx, double *gy, double *gz, size_t count);
+void simplex_sample3f_batch_gradient(SimplexContext, const float *x, const float *y, const float *z, float *out,
+	float *gx, float *gy, float *gz, size_t count);
+
 #ifdef __cplusplus
 	}
 #endif
@@ -0,0 +1,334 @@
+/*
+ * Body of the batched 3D sampler, included by simplex.c once per precision
+ * with BATCH_REAL, BATCH_FABS, BATCH_GRADS (the context's gradient tables)
+ * and BATCH_SUFFIX defined.
+ *
+ * Everything per lane is kept in BATCH_REAL, flags are 0 or 1 and lattice
+ * offsets are small integers, so every operation works on the same vector
+ * width. Mixing in narrower ints and bools stops GCC from vectorizing.
+ */
+
+#define BATCH_JOIN2(a, b) a##b
+#define BATCH_JOIN(a, b) BATCH_JOIN2(a, b)
+
+#define batch_tables BATCH_JOIN(batch_tables, BATCH_SUFFIX)
+#define batch_sample BATCH_JOIN(batch_sample, BATCH_SUFFIX)
+#define add_sample BATCH_JOIN(add_sample, BATCH_SUFFIX)
+#define flag_or BATCH_JOIN(flag_or, BATCH_SUFFIX)
+#define flag BATCH_JOIN(flag, BATCH_SUFFIX)
+#define contribute3 BATCH_JOIN(contribute3, BATCH_SUFFIX)
+#define sample3_block BATCH_JOIN(sample3_block, BATCH_SUFFIX)
+#define sample3_batch_range BATCH_JOIN(sample3_batch_range, BATCH_SUFFIX)
+#define sample3_batch_kernel BATCH_JOIN(sample3_batch_kernel, BATCH_SUFFIX)
+#define sample3_batch_generic BATCH_JOIN(sample3_batch_generic, BATCH_SUFFIX)
+#define sample3_batch_avx2 BATCH_JOIN(sample3_batch_avx2, BATCH_SUFFIX)
+#define sample3_batch_sse41 BATCH_JOIN(sample3_batch_sse41, BATCH_SUFFIX)
+
+struct batch_tables {
+	const int32_t *perm;
+	const BATCH_REAL *gradX;
+	const BATCH_REAL *gradY;
+	const BATCH_REAL *gradZ;
+};
+
+/* A noise value and its partial derivatives */
+struct batch_sample {
+	BATCH_REAL value;
+	BATCH_REAL dx;
+	BATCH_REAL dy;
+	BATCH_REAL dz;
+};
+
+static BATCH_INLINE BATCH_REAL flag(int condition)
+{
+	return condition ? 1.0 : 0.0;
+}
+
+static BATCH_INLINE BATCH_REAL flag_or(BATCH_REAL a, BATCH_REAL b)
+{
+	return a + b - a * b;
+}
+
+static BATCH_INLINE struct batch_sample add_sample(struct batch_sample a, struct batch_sample b)
+{
+	struct batch_sample sum = {a.value + b.value, a.dx + b.dx, a.dy + b.dy, a.dz + b.dz};
+	return sum;
+}
+
+/*
+ * Each contribution is attn^4 * extrapolation with attn = 2 - |d|^2, where d
+ * moves one for one with the sample point, so its gradient is
+ * attn^4 * grad - 8 * attn^3 * extrapolation * d.
+ */
+static BATCH_INLINE struct batch_sample contribute3(struct batch_tables tables, BATCH_REAL xsb, BATCH_REAL ysb, BATCH_REAL zsb,
+	BATCH_REAL dx0, BATCH_REAL dy0, BATCH_REAL dz0, BATCH_REAL ox, BATCH_REAL oy, BATCH_REAL oz, BATCH_REAL enabled, int gradient)
+{
+	const int32_t *perm = tables.perm;
+	BATCH_REAL squish = (ox + oy + oz) * (BATCH_REAL) SQUISH_CONSTANT_3D;
+	BATCH_REAL dx = dx0 - ox - squish;
+	BATCH_REAL dy = dy0 - oy - squish;
+	BATCH_REAL dz = dz0 - oz - squish;
+	BATCH_REAL attn = 2 - dx * dx - dy * dy - dz * dz;
+	int index = (perm[(perm[(int) (xsb + ox) & 0xFF] + (int) (ysb + oy)) & 0xFF] + (int) (zsb + oz)) & 0xFF;
+	BATCH_REAL gradX = tables.gradX[index];
+	BATCH_REAL gradY = tables.gradY[index];
+	BATCH_REAL gradZ = tables.gradZ[index];
+	BATCH_REAL extrapolation = gradX * dx + gradY * dy + gradZ * dz;
+	attn = (attn > 0 ? attn : 0) * enabled;
+	BATCH_REAL attn2 = attn * attn;
+	BATCH_REAL attn4 = attn2 * attn2;
+
+	struct batch_sample sample = {attn4 * extrapolation, 0, 0, 0};
+	if (gradient) {
+		BATCH_REAL falloff = -8 * attn2 * attn * extrapolation;
+		sample.dx = attn4 * gradX + falloff * dx;
+		sample.dy = attn4 * gradY + falloff * dy;
+		sample.dz = attn4 * gradZ + falloff * dz;
+	}
+	return sample;
+}
+
+/* Gradients are only computed, and gxv/gyv/gzv only touched, if gradient is set */
+static BATCH_INLINE void sample3_block(const struct osn_context *ctx,
+	const BATCH_REAL *restrict xv, const BATCH_REAL *restrict yv, const BATCH_REAL *restrict zv, BATCH_REAL *restrict out,
+	BATCH_REAL *restrict gxv, BATCH_REAL *restrict gyv, BATCH_REAL *restrict gzv, int gradient)
+{
+	/* Going through the context inside the loop stops GCC recognizing the
+	   table lookups as gathers. */
+	struct batch_tables tables = {ctx->permBatch, ctx->BATCH_GRADS[0], ctx->BATCH_GRADS[1], ctx->BATCH_GRADS[2]};
+
+	for (int lane = 0; lane < SIMPLEX_BATCH_LANES; lane++) {
+		BATCH_REAL x = xv[lane];
+		BATCH_REAL y = yv[lane];
+		BATCH_REAL z = zv[lane];
+
+		BATCH_REAL stretchOffset = (x + y + z) * (BATCH_REAL) STRETCH_CONSTANT_3D;
+		BATCH_REAL xs = x + stretchOffset;
+		BATCH_REAL ys = y + stretchOffset;
+		BATCH_REAL zs = z + stretchOffset;
+
+		BATCH_REAL xsb = (BATCH_REAL) (int) xs;
+		BATCH_REAL ysb = (BATCH_REAL) (int) ys;
+		BATCH_REAL zsb = (BATCH_REAL) (int) zs;
+		xsb -= flag(xs < xsb);
+		ysb -= flag(ys < ysb);
+		zsb -= flag(zs < zsb);
+
+		BATCH_REAL squishOffset = (xsb + ysb + zsb) * (BATCH_REAL) SQUISH_CONSTANT_3D;
+		BATCH_REAL xins = xs - xsb;
+		BATCH_REAL yins = ys - ysb;
+		BATCH_REAL zins = zs - zsb;
+		BATCH_REAL inSum = xins + yins + zins;
+		BATCH_REAL dx0 = x - (xsb + squishOffset);
+		BATCH_REAL dy0 = y - (ysb + squishOffset);
+		BATCH_REAL dz0 = z - (zsb + squishOffset);
+
+		BATCH_REAL near = flag(inSum <= 1);
+		BATCH_REAL far = flag(inSum >= 2);
+		BATCH_REAL middle = 1 - near - far;
+
+		/* Points are kept as one flag per axis rather than bit masks, so |
+		   becomes flag_or and & a product. */
+
+		/* Extra vertices when inside the tetrahedron at (0,0,0) */
+		BATCH_REAL n_as = xins, n_bs = yins;
+		BATCH_REAL n_swapB = flag(n_as >= n_bs) * flag(zins > n_bs);
+		BATCH_REAL n_swapA = (1 - n_swapB) * flag(n_as < n_bs) * flag(zins > n_as);
+		n_bs = n_swapB != 0 ? zins : n_bs;
+		n_as = n_swapA != 0 ? zins : n_as;
+		BATCH_REAL n_ax = 1 - n_swapA, n_ay = 0, n_az = n_swapA;
+		BATCH_REAL n_bx = 0, n_by = 1 - n_swapB, n_bz = n_swapB;
+		BATCH_REAL n_wins = 1 - inSum;
+		BATCH_REAL n_closeOrigin = flag_or(flag(n_wins > n_as), flag(n_wins > n_bs));
+		BATCH_REAL n_pickB = flag(n_bs > n_as);
+		BATCH_REAL n_cx = n_closeOrigin * (n_pickB * n_bx + (1 - n_pickB) * n_ax) + (1 - n_closeOrigin) * flag_or(n_ax, n_bx);
+		BATCH_REAL n_cy = n_closeOrigin * (n_pickB * n_by + (1 - n_pickB) * n_ay) + (1 - n_closeOrigin) * flag_or(n_ay, n_by);
+		BATCH_REAL n_cz = n_closeOrigin * (n_pickB * n_bz + (1 - n_pickB) * n_az) + (1 - n_closeOrigin) * flag_or(n_az, n_bz);
+		BATCH_REAL n_shiftY = n_closeOrigin * n_cx;
+		BATCH_REAL n_x0 = n_cx - (1 - n_cx) * n_closeOrigin;
+		BATCH_REAL n_x1 = n_cx - (1 - n_cx) * (1 - n_closeOrigin);
+		BATCH_REAL n_y0 = n_cy - (1 - n_cy) * n_shiftY;
+		BATCH_REAL n_y1 = n_cy - (1 - n_cy) * (1 - n_shiftY);
+		BATCH_REAL n_z0 = n_cz;
+		BATCH_REAL n_z1 = 2 * n_cz - 1;
+
+		/* Extra vertices when inside the tetrahedron at (1,1,1) */
+		BATCH_REAL f_as = xins, f_bs = yins;
+		BATCH_REAL f_swapB = flag(f_as <= f_bs) * flag(zins < f_bs);
+		BATCH_REAL f_swapA = (1 - f_swapB) * flag(f_as > f_bs) * flag(zins < f_as);
+		f_bs = f_swapB != 0 ? zins : f_bs;
+		f_as = f_swapA != 0 ? zins : f_as;
+		BATCH_REAL f_ax = f_swapA, f_ay = 1, f_az = 1 - f_swapA;
+		BATCH_REAL f_bx = 1, f_by = f_swapB, f_bz = 1 - f_swapB;
+		BATCH_REAL f_wins = 3 - inSum;
+		BATCH_REAL f_closeFar = flag_or(flag(f_wins < f_as), flag(f_wins < f_bs));
+		BATCH_REAL f_pickB = flag(f_bs < f_as);
+		BATCH_REAL f_cx = f_closeFar * (f_pickB * f_bx + (1 - f_pickB) * f_ax) + (1 - f_closeFar) * (f_ax * f_bx);
+		BATCH_REAL f_cy = f_closeFar * (f_pickB * f_by + (1 - f_pickB) * f_ay) + (1 - f_closeFar) * (f_ay * f_by);
+		BATCH_REAL f_cz = f_closeFar * (f_pickB * f_bz + (1 - f_pickB) * f_az) + (1 - f_closeFar) * (f_az * f_bz);
+		BATCH_REAL f_shiftY = f_closeFar * (1 - f_cx);
+		BATCH_REAL f_x0 = f_cx * (1 + f_closeFar);
+		BATCH_REAL f_x1 = f_cx * (2 - f_closeFar);
+		BATCH_REAL f_y0 = f_cy * (1 + f_shiftY);
+		BATCH_REAL f_y1 = f_cy * (2 - f_shiftY);
+		BATCH_REAL f_z0 = f_cz;
+		BATCH_REAL f_z1 = 2 * f_cz;
+
+		/* Extra vertices when inside the octahedron in between, deciding
+		   between (0,0,1)/(1,1,0) and (0,1,0)/(1,0,1) as closest then letting
+		   the closer of (1,0,0)/(0,1,1) replace the further of those */
+		BATCH_REAL p1 = xins + yins;
+		BATCH_REAL p2 = xins + zins;
+		BATCH_REAL p3 = yins + zins;
+		BATCH_REAL m_aFar = flag(p1 > 1);
+		BATCH_REAL m_bFar = flag(p2 > 1);
+		BATCH_REAL m_far3 = flag(p3 > 1);
+		BATCH_REAL m_as = BATCH_FABS(p1 - 1);
+		BATCH_REAL m_bs = BATCH_FABS(p2 - 1);
+		BATCH_REAL m_score = BATCH_FABS(p3 - 1);
+		BATCH_REAL m_ax = m_aFar, m_ay = m_aFar, m_az = 1 - m_aFar;
+		BATCH_REAL m_bx = m_bFar, m_by = 1 - m_bFar, m_bz = m_bFar;
+		BATCH_REAL m_3x = 1 - m_far3, m_3y = m_far3, m_3z = m_far3;
+		BATCH_REAL m_replaceA = flag(m_as <= m_bs) * flag(m_as < m_score);
+		BATCH_REAL m_replaceB = (1 - m_replaceA) * flag(m_as > m_bs) * flag(m_bs < m_score);
+		m_ax = m_replaceA * m_3x + (1 - m_replaceA) * m_ax;
+		m_ay = m_replaceA * m_3y + (1 - m_replaceA) * m_ay;
+		m_az = m_replaceA * m_3z + (1 - m_replaceA) * m_az;
+		m_aFar = m_replaceA * m_far3 + (1 - m_replaceA) * m_aFar;
+		m_bx = m_replaceB * m_3x + (1 - m_replaceB) * m_bx;
+		m_by = m_replaceB * m_3y + (1 - m_replaceB) * m_by;
+		m_bz = m_replaceB * m_3z + (1 - m_replaceB) * m_bz;
+		m_bFar = m_replaceB * m_far3 + (1 - m_replaceB) * m_bFar;
+
+		/* Both closest points on the same side give that side's corner plus
+		   a step of 2 along their shared axis (far side) or a permutation of
+		   (-1,1,1) on their omitted axis (near side). Otherwise one extra is
+		   the (-1,1,1) permutation of the far point and the other the step of
+		   2 of the near point. */
+		BATCH_REAL m_same = 1 - BATCH_FABS(m_aFar - m_bFar);
+		BATCH_REAL m_c1x = m_same * flag_or(m_ax, m_bx) + (1 - m_same) * (m_aFar * m_ax + (1 - m_aFar) * m_bx);
+		BATCH_REAL m_c1y = m_same * flag_or(m_ay, m_by) + (1 - m_same) * (m_aFar * m_ay + (1 - m_aFar) * m_by);
+		BATCH_REAL m_c2x = m_same * (m_ax * m_bx) + (1 - m_same) * (m_aFar * m_bx + (1 - m_aFar) * m_ax);
+		BATCH_REAL m_c2y = m_same * (m_ay * m_by) + (1 - m_same) * (m_aFar * m_by + (1 - m_aFar) * m_ay);
+		BATCH_REAL m_flipX = 1 - m_c1x;
+		BATCH_REAL m_flipY = (1 - m_flipX) * (1 - m_c1y);
+		BATCH_REAL m_flipZ = (1 - m_flipX) * (1 - m_flipY);
+		BATCH_REAL m_stepX = m_c2x;
+		BATCH_REAL m_stepY = (1 - m_stepX) * m_c2y;
+		BATCH_REAL m_stepZ = (1 - m_stepX) * (1 - m_stepY);
+		BATCH_REAL m_bothFar = m_same * m_aFar;
+		BATCH_REAL m_bothNear = m_same * (1 - m_aFar);
+		BATCH_REAL m_x0 = m_same * m_bothFar + (1 - m_same) * (1 - 2 * m_flipX);
+		BATCH_REAL m_y0 = m_same * m_bothFar + (1 - m_same) * (1 - 2 * m_flipY);
+		BATCH_REAL m_z0 = m_same * m_bothFar + (1 - m_same) * (1 - 2 * m_flipZ);
+		BATCH_REAL m_x1 = m_bothNear * (1 - 2 * m_flipX) + (1 - m_bothNear) * 2 * m_stepX;
+		BATCH_REAL m_y1 = m_bothNear * (1 - 2 * m_flipY) + (1 - m_bothNear) * 2 * m_stepY;
+		BATCH_REAL m_z1 = m_bothNear * (1 - 2 * m_flipZ) + (1 - m_bothNear) * 2 * m_stepZ;
+
+		BATCH_REAL x0 = near * n_x0 + far * f_x0 + middle * m_x0;
+		BATCH_REAL y0 = near * n_y0 + far * f_y0 + middle * m_y0;
+		BATCH_REAL z0 = near * n_z0 + far * f_z0 + middle * m_z0;
+		BATCH_REAL x1 = near * n_x1 + far * f_x1 + middle * m_x1;
+		BATCH_REAL y1 = near * n_y1 + far * f_y1 + middle * m_y1;
+		BATCH_REAL z1 = near * n_z1 + far * f_z1 + middle * m_z1;
+
+		struct batch_sample sum = {0, 0, 0, 0};
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 0, 0, 0, near, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 1, 0, 0, 1 - far, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 0, 1, 0, 1 - far, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 0, 0, 1, 1 - far, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 1, 1, 0, 1 - near, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 1, 0, 1, 1 - near, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 0, 1, 1, 1 - near, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, 1, 1, 1, far, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, x0, y0, z0, 1, gradient));
+		sum = add_sample(sum, contribute3(tables, xsb, ysb, zsb, dx0, dy0, dz0, x1, y1, z1, 1, gradient));
+
+		out[lane] = sum.value / (BATCH_REAL) NORM_CONSTANT_3D;
+		if (gradient) {
+			gxv[lane] = sum.dx / (BATCH_REAL) NORM_CONSTANT_3D;
+			gyv[lane] = sum.dy / (BATCH_REAL) NORM_CONSTANT_3D;
+			gzv[lane] = sum.dz / (BATCH_REAL) NORM_CONSTANT_3D;
+		}
+	}
+}
+
+static BATCH_INLINE void sample3_batch_range(const struct osn_context *ctx,
+	const BATCH_REAL *x, const BATCH_REAL *y, const BATCH_REAL *z, BATCH_REAL *out,
+	BATCH_REAL *gx, BATCH_REAL *gy, BATCH_REAL *gz, size_t count, int gradient)
+{
+	size_t i = 0;
+	for (; i + SIMPLEX_BATCH_LANES <= count; i += SIMPLEX_BATCH_LANES) {
+		if (gradient)
+			sample3_block(ctx, x + i, y + i, z + i, out + i, gx + i, gy + i, gz + i, 1);
+		else
+			sample3_block(ctx, x + i, y + i, z + i, out + i, NULL, NULL, NULL, 0);
+	}
+	if (i == count)
+		return;
+
+	/* Pad the remainder out to a full block */
+	BATCH_REAL xt[SIMPLEX_BATCH_LANES] = {0}, yt[SIMPLEX_BATCH_LANES] = {0}, zt[SIMPLEX_BATCH_LANES] = {0};
+	BATCH_REAL ot[SIMPLEX_BATCH_LANES], gxt[SIMPLEX_BATCH_LANES], gyt[SIMPLEX_BATCH_LANES], gzt[SIMPLEX_BATCH_LANES];
+	memcpy(xt, x + i, (count - i) * sizeof *xt);
+	memcpy(yt, y + i, (count - i) * sizeof *yt);
+	memcpy(zt, z + i, (count - i) * sizeof *zt);
+	sample3_block(ctx, xt, yt, zt, ot, gxt, gyt, gzt, gradient);
+	memcpy(out + i, ot, (count - i) * sizeof *ot);
+	if (gradient) {
+		memcpy(gx + i, gxt, (count - i) * sizeof *gxt);
+		memcpy(gy + i, gyt, (count - i) * sizeof *gyt);
+		memcpy(gz + i, gzt, (count - i) * sizeof *gzt);
+	}
+}
+
+/* Gradients are written to gx/gy/gz unless gx is NULL */
+static BATCH_INLINE void sample3_batch_kernel(const struct osn_context *ctx,
+	const BATCH_REAL *x, const BATCH_REAL *y, const BATCH_REAL *z, BATCH_REAL *out,
+	BATCH_REAL *gx, BATCH_REAL *gy, BATCH_REAL *gz, size_t count)
+{
+	if (gx)
+		sample3_batch_range(ctx, x, y, z, out, gx, gy, gz, count, 1);
+	else
+		sample3_batch_range(ctx, x, y, z, out, NULL, NULL, NULL, count, 0);
+}
+
+static void sample3_batch_generic(const struct osn_context *ctx,
+	const BATCH_REAL *x, const BATCH_REAL *y, const BATCH_REAL *z, BATCH_REAL *out,
+	BATCH_REAL *gx, BATCH_REAL *gy, BATCH_REAL *gz, size_t count)
+{
+	sample3_batch_kernel(ctx, x, y, z, out, gx, gy, gz, count);
+}
+
+#ifdef SIMPLEX_BATCH_X86
+__attribute__((target("avx2,fma")))
+static void sample3_batch_avx2(const struct osn_context *ctx,
+	const BATCH_REAL *x, const BATCH_REAL *y, const BATCH_REAL *z, BATCH_REAL *out,
+	BATCH_REAL *gx, BATCH_REAL *gy, BATCH_REAL *gz, size_t count)
+{
+	sample3_batch_kernel(ctx, x, y, z, out, gx, gy, gz, count);
+}
+
+__attribute__((target("sse4.1")))
+static void sample3_batch_sse41(const struct osn_context *ctx,
+	const BATCH_REAL *x, const BATCH_REAL *y, const BATCH_REAL *z, BATCH_REAL *out,
+	BATCH_REAL *gx, BATCH_REAL *gy, BATCH_REAL *gz, size_t count)
+{
+	sample3_batch_kernel(ctx, x, y, z, out, gx, gy, gz, count);
+}
+#endif
+
+#undef batch_tables
+#undef batch_sample
+#undef add_sample
+#undef flag_or
+#undef flag
+#undef contribute3
+#undef sample3_block
+#undef sample3_batch_range
+#undef sample3_batch_kernel
+#undef sample3_batch_generic
+#undef sample3_batch_avx2
+#undef sample3_batch_sse41
+#undef BATCH_JOIN
+#undef BATCH_JOIN2
@@ -1,8 +1,13 @@
 #include "3d.h"
 
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
 #define PI 3.14159265358979323846f
 
 void
@@ -65,7 +70,7 @@ vec3sub(struct vec3 a, struct vec3 b)
     };
 }
 
-static float
+float
 vec3dot(struct vec3 a, struct vec3 b)
 {
     return a.x * b.x + a.y * b.y + a.z * b.z;
@@ -95,6 +100,48 @@ vec3imuls(struct vec3* vector, float scalar)
     vector->z *= scalar;
 }
 
+void
+vec3_octahedral_encode(struct vec3 unit, float encoded[2])
+{
+    float l1 = fabsf(unit.x) + fabsf(unit.y) + fabsf(unit.z);
+    float x  = unit.x / l1;
+    float y  = unit.y / l1;
+    if (unit.z < 0.0f) {
+        float folded_x = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        float folded_y = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+        x              = folded_x;
+        y              = folded_y;
+    }
+    encoded[0] = x;
+    encoded[1] = y;
+}
+
+struct vec3_soa
+vec3_soa_create(size_t capacity)
+{
+    // each component is padded out so the next one starts aligned as well
+    const size_t lane   = VEC3_SOA_ALIGNMENT / sizeof(float);
+    const size_t padded = (capacity / lane + 1) * lane;
+    const size_t size   = 3 * padded * sizeof(float);
+#ifdef _MSC_VER
+    float* block = _aligned_malloc(size, VEC3_SOA_ALIGNMENT);
+#else
+    float* block = aligned_alloc(VEC3_SOA_ALIGNMENT, size);
+#endif
+    if (block == NULL) return (struct vec3_soa){NULL, NULL, NULL};
+    return (struct vec3_soa){block, block + padded, block + 2 * padded};
+}
+
+void
+vec3_soa_destroy(struct vec3_soa soa)
+{
+#ifdef _MSC_VER
+    _aligned_free(soa.x);
+#else
+    free(soa.x);
+#endif
+}
+
 struct mat4
 projection_matrix(float fovy, float aspect, float near, float far)
 {
@@ -1,6 +1,8 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <stddef.h>
+
 struct vec3 {
     float x;
     float y;
@@ -12,6 +14,7 @@ struct vec3 vec3add(struct vec3, struct vec3);
 struct vec3 vec3sub(struct vec3, struct vec3);
 struct vec3 vec3adds(struct vec3, float scalar);
 struct vec3 vec3muls(struct vec3, float scalar);
+float       vec3dot(struct vec3, struct vec3);
 
 // in place operations
 void vec3iadd(struct vec3*, struct vec3);
@@ -19,6 +22,56 @@ void vec3isub(struct vec3*, struct vec3);
 void vec3imuls(struct vec3*, float scalar);
 void vec3norm(struct vec3*);
 
+// octahedral encoding of a unit vector, two coordinates in [-1, 1] found by
+// projecting it onto an octahedron and folding the lower half over the upper.
+// Quantizes far more evenly over the sphere than the xyz components would.
+void vec3_octahedral_encode(struct vec3 unit, float encoded[2]);
+
+// structure of arrays storage for many vec3s, each component is its own
+// VEC3_SOA_ALIGNMENT aligned array so loops over the components vectorize.
+// Offset copies can be passed around as views but only the struct returned by
+// vec3_soa_create may be destroyed.
+#define VEC3_SOA_ALIGNMENT 64
+
+struct vec3_soa {
+    float* x;
+    float* y;
+    float* z;
+};
+
+// x, y and z are NULL if the allocation failed
+struct vec3_soa vec3_soa_create(size_t capacity);
+void            vec3_soa_destroy(struct vec3_soa);
+
+// defined here so they inline into the loops walking the arrays
+static inline struct vec3_soa
+vec3_soa_offset(struct vec3_soa soa, size_t offset)
+{
+    return (struct vec3_soa){
+        soa.x + offset,
+        soa.y + offset,
+        soa.z + offset,
+    };
+}
+
+static inline struct vec3
+vec3_soa_get(struct vec3_soa soa, size_t index)
+{
+    return (struct vec3){
+        soa.x[index],
+        soa.y[index],
+        soa.z[index],
+    };
+}
+
+static inline void
+vec3_soa_set(struct vec3_soa soa, size_t index, struct vec3 vector)
+{
+    soa.x[index] = vector.x;
+    soa.y[index] = vector.y;
+    soa.z[index] = vector.z;
+}
+
 struct mat4 {
     float values[4][4];
 };
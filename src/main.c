@@ -12,6 +12,7 @@
 #define INITIAL_SUBDIVISIONS (PLANET_MAX_SUBDIVISIONS / 2)
 #define INITIAL_SEED 0
 #define ROTATION_SPEED_INITIAL 0.1f
+#define UPLOAD_BUDGET_INITIAL_MB ((int)(RENDERER_DEFAULT_UPLOAD_BUDGET >> 20))
 
 int
 main(void)
@@ -107,9 +108,62 @@ main(void)
             IMGUI_WINDOW_ALWAYS_AUTO_RESIZE | IMGUI_WINDOW_NO_RESIZE
         );
 
-        struct planet_mesh mesh = planet_acquire_mesh(planet);
-        planet_release_mesh(planet);
-        imgui_text("vertex_count: %d", mesh.vertex_count);
+        // the renderer is the only one acquiring meshes, it may still be
+        // uploading the last one it acquired
+        struct planet_stats stats = planet_get_stats(planet);
+        imgui_text(
+            "vertex_count: %llu", (unsigned long long)stats.vertex_count
+        );
+        imgui_text(
+            "build: %.1f ms (%u threads)",
+            stats.last_build_ms,
+            stats.worker_count
+        );
+        imgui_text(
+            "passes: %.1f ms vertices, %.1f ms normals",
+            stats.vertex_pass_ms,
+            stats.normal_pass_ms
+        );
+        imgui_text(
+            "abandoned builds: %llu",
+            (unsigned long long)stats.abandoned_builds
+        );
+        imgui_text(
+            "noise calls: %llu (%llu saved)",
+            (unsigned long long)stats.noise_calls,
+            (unsigned long long)stats.noise_calls_saved
+        );
+        imgui_text(
+            "topology cache: %llu hits, %llu misses, %.1f MB",
+            (unsigned long long)stats.topology_hits,
+            (unsigned long long)stats.topology_misses,
+            (double)stats.topology_bytes / (1024.0 * 1024.0)
+        );
+        imgui_text(
+            "vertex buffers: %.1f MB",
+            (double)stats.buffer_bytes / (1024.0 * 1024.0)
+        );
+
+        struct renderer_stats render_stats = renderer_get_stats(renderer);
+        imgui_text(
+            "upload: %.1f MB, %.2f ms%s",
+            (double)render_stats.upload_bytes / (1024.0 * 1024.0),
+            render_stats.upload_stall_ms,
+            render_stats.upload_active ? " (streaming)" : ""
+        );
+        imgui_text(
+            "uploads: %llu, last over %u frames",
+            (unsigned long long)render_stats.uploads,
+            render_stats.last_upload_frames
+        );
+
+        static int previous_threads = 0;
+        static int threads          = 0;
+        imgui_slideri("threads", &threads, 0, SDL_GetCPUCount());
+        if (threads != previous_threads) {
+            previous_threads = threads;
+            planet_set_worker_count(planet, (uint32_t)threads);
+        }
 
         static int previous_seed = INITIAL_SEED;
         static int seed          = INITIAL_SEED;
@@ -129,6 +183,14 @@ main(void)
             planet_set_subdivisions(planet, subdivisions);
         }
 
+        static int previous_upload_budget = UPLOAD_BUDGET_INITIAL_MB;
+        static int upload_budget          = UPLOAD_BUDGET_INITIAL_MB;
+        imgui_slideri("upload MB/frame", &upload_budget, 1, 32);
+        if (upload_budget != previous_upload_budget) {
+            previous_upload_budget = upload_budget;
+            renderer_set_upload_budget(renderer, (size_t)upload_budget << 20);
+        }
+
         static float rotation_speed          = ROTATION_SPEED_INITIAL;
         static float previous_rotation_speed = ROTATION_SPEED_INITIAL;
         imgui_sliderf("rotation", &rotation_speed, -1.0f, 1.0f);
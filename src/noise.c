@@ -1,5 +1,88 @@
 #include "noise.h"
 
+#include <stdbool.h>
+
+struct fbm_octave
+fbm_octave(uint32_t layer, float gain, float freq, float lacunarity)
+{
+    // mirrors the loop in fbm exactly so samples match bit for bit
+    float scale  = 1.0f;
+    float factor = 1.0f;
+    for (uint32_t i = 0; i < layer; i++) {
+        scale *= freq;
+        factor *= gain;
+        freq *= lacunarity;
+    }
+    return (struct fbm_octave){
+        .location_scale = scale * freq,
+        .amplitude      = factor,
+    };
+}
+
+float
+fbm_octave_sample(
+    SimplexContext simplex, struct vec3 location, struct fbm_octave octave
+)
+{
+    location = vec3muls(location, octave.location_scale);
+    float noise =
+        (float)simplex_sample3(simplex, location.x, location.y, location.z);
+    return noise * octave.amplitude;
+}
+
+void
+fbm_octave_sample_batch(
+    SimplexContext    simplex,
+    struct vec3_soa   locations,
+    uint32_t          count,
+    struct fbm_octave octave,
+    float*            out,
+    struct vec3*      gradients
+)
+{
+    float x[NOISE_BATCH_SIZE];
+    float y[NOISE_BATCH_SIZE];
+    float z[NOISE_BATCH_SIZE];
+    float noise[NOISE_BATCH_SIZE];
+    float dx[NOISE_BATCH_SIZE];
+    float dy[NOISE_BATCH_SIZE];
+    float dz[NOISE_BATCH_SIZE];
+
+    // chain rule through the location scaling
+    const float slope = octave.amplitude * octave.location_scale;
+
+    for (uint32_t begin = 0; begin < count; begin += NOISE_BATCH_SIZE) {
+        uint32_t size = count - begin;
+        if (size > NOISE_BATCH_SIZE) size = NOISE_BATCH_SIZE;
+
+        // scaled in float first, as fbm_octave_sample does
+        for (uint32_t i = 0; i < size; i++) {
+            x[i] = locations.x[begin + i] * octave.location_scale;
+            y[i] = locations.y[begin + i] * octave.location_scale;
+            z[i] = locations.z[begin + i] * octave.location_scale;
+        }
+
+        if (gradients == NULL) {
+            simplex_sample3f_batch(simplex, x, y, z, noise, size);
+        }
+        else {
+            simplex_sample3f_batch_gradient(
+                simplex, x, y, z, noise, dx, dy, dz, size
+            );
+            for (uint32_t i = 0; i < size; i++) {
+                gradients[begin + i] = (struct vec3){
+                    dx[i] * slope,
+                    dy[i] * slope,
+                    dz[i] * slope,
+                };
+            }
+        }
+        for (uint32_t i = 0; i < size; i++) {
+            out[begin + i] = noise[i] * octave.amplitude;
+        }
+    }
+}
+
 float
 fbm(SimplexContext simplex,
     struct vec3    location,
@@ -9,12 +92,15 @@ fbm(SimplexContext simplex,
     float          lacunarity)
 {
     float total  = 0.0f;
+    float scale  = 1.0f;
     float factor = 1.0f;
     for (unsigned int layer = 0; layer < layers; layer++) {
-        vec3imuls(&location, freq);
-        float noise =
-            (float)simplex_sample3(simplex, location.x, location.y, location.z);
-        total += noise * factor;
+        scale *= freq;
+        total += fbm_octave_sample(
+            simplex,
+            location,
+            (struct fbm_octave){.location_scale = scale, .amplitude = factor}
+        );
         factor *= gain;
         freq *= lacunarity;
     }
@@ -34,3 +120,62 @@ terrain_noise(
     float height = fbm(simplex, location, layers, gain, frequency, lacunarity);
     return height;
 }
+
+void
+terrain_noise_batch(
+    SimplexContext  simplex,
+    struct vec3_soa locations,
+    uint32_t        count,
+    uint32_t        layers,
+    float           gain,
+    float           frequency,
+    float           lacunarity,
+    float*          heights,
+    struct vec3*    gradients,
+    uint32_t        gradient_layers
+)
+{
+    static const struct vec3 vec3zero = {0.0f, 0.0f, 0.0f};
+
+    float       samples[NOISE_BATCH_SIZE];
+    struct vec3 sample_gradients[NOISE_BATCH_SIZE];
+
+    for (uint32_t begin = 0; begin < count; begin += NOISE_BATCH_SIZE) {
+        uint32_t size = count - begin;
+        if (size > NOISE_BATCH_SIZE) size = NOISE_BATCH_SIZE;
+
+        float*       total          = heights + begin;
+        struct vec3* total_gradient = (gradients) ? gradients + begin : NULL;
+        for (uint32_t i = 0; i < size; i++) {
+            total[i] = 0.0f;
+            if (total_gradient) total_gradient[i] = vec3zero;
+        }
+
+        // same octave sequence and summation order as fbm
+        float scale  = 1.0f;
+        float factor = 1.0f;
+        float freq   = frequency;
+        for (uint32_t layer = 0; layer < layers; layer++) {
+            scale *= freq;
+            struct fbm_octave octave = {
+                .location_scale = scale,
+                .amplitude      = factor,
+            };
+            bool sample_gradient = total_gradient && layer < gradient_layers;
+            fbm_octave_sample_batch(
+                simplex,
+                vec3_soa_offset(locations, begin),
+                size,
+                octave,
+                samples,
+                (sample_gradient) ? sample_gradients : NULL
+            );
+            for (uint32_t i = 0; i < size; i++) total[i] += samples[i];
+            for (uint32_t i = 0; sample_gradient && i < size; i++) {
+                vec3iadd(total_gradient + i, sample_gradients[i]);
+            }
+            factor *= gain;
+            freq *= lacunarity;
+        }
+    }
+}
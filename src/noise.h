@@ -6,6 +6,37 @@
 #include "3d.h"
 #include "../simplex/simplex.h"
 
+// the scale applied to the location and the weight of a single fbm layer,
+// these are the same for every location sampled with the same parameters
+struct fbm_octave {
+    float location_scale;
+    float amplitude;
+};
+
+// fbm is the sum of its octave samples for layers [0, layers), summing them
+// one at a time in order gives exactly the same result
+struct fbm_octave fbm_octave(
+    uint32_t layer, float gain, float frequency, float lacunarity
+);
+float fbm_octave_sample(SimplexContext, struct vec3, struct fbm_octave);
+
+// the number of locations sampled per call to the simplex batch kernel
+#define NOISE_BATCH_SIZE 64
+
+// fbm_octave_sample for every location through the batched simplex kernel,
+// sampled in the precision the context was created with so the results only
+// match fbm_octave_sample exactly for double precision contexts. If gradients
+// isn't NULL it receives the gradient of each sample with respect to its
+// location. Locations are only read.
+void fbm_octave_sample_batch(
+    SimplexContext    simplex,
+    struct vec3_soa   locations,
+    uint32_t          count,
+    struct fbm_octave octave,
+    float*            out,
+    struct vec3*      gradients
+);
+
 float terrain_noise(
     SimplexContext simplex,
     struct vec3    location,
@@ -15,4 +46,21 @@ float terrain_noise(
     float          lacunarity
 );
 
+// terrain_noise for every location, iterating octave by octave over the
+// locations so each octave goes through the batched simplex kernel. Unless
+// gradients is NULL the gradient of the first gradient_layers octaves of each
+// height is accumulated alongside it.
+void terrain_noise_batch(
+    SimplexContext  simplex,
+    struct vec3_soa locations,
+    uint32_t        count,
+    uint32_t        layers,
+    float           gain,
+    float           frequency,
+    float           lacunarity,
+    float*          heights,
+    struct vec3*    gradients,
+    uint32_t        gradient_layers
+);
+
 #endif  // NOISE_H
@@ -1,15 +1,5 @@
 #include "planet.h"
 
-// Not exactly sure why this isn't working for me
-// with cl.exe. As far as I can tell it's supposed to be
-// supported and the header exists but including it spews
-// a ton of syntax errors for me. A quick check online yielded
-// no answers so I guess I'll just hack around it as much
-// as that sucks.
-#ifndef _WIN32
-#include <stdatomic.h>
-#endif
-
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -19,6 +9,7 @@
 #include <SDL2/SDL.h>
 
 #include "noise.h"
+#include "thread_pool.h"
 
 struct generation_params {
     uint32_t subdivisions;
@@ -30,382 +21,1616 @@ struct generation_params {
     float    noise_scale;
 };
 
+// indices and the unit sphere direction of each vertex only depend on the
+// subdivisions, so once built they are never written again and every build
+// with those subdivisions shares them
+struct planet_topology {
+    uint64_t        version;  // 0 until indices and directions are complete
+    uint32_t        subdivisions;
+    uint64_t        last_used;
+    size_t          bytes;
+    uint32_t*       indices;
+    struct vec3_soa directions;
+    uint32_t*       neighbours;  // only for height meshes, see planet_mesh
+};
+
+// height meshes have their normals rebuilt by the renderer so the generator
+// doesn't produce any
+#define HEIGHT_VERTICES (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_HEIGHTS)
+
 struct planet {
     SDL_mutex*  mutex;
     SDL_Thread* thread;
-#ifndef _WIN32
-    atomic_int shutdown_signal;
-#else
-    int shutdown_signal;
-#endif
+
+    // signaled whenever configured_params changes or on shutdown so the
+    // generator can sleep while there is nothing to do
+    SDL_cond* generator_wakeup;
+    bool      shutdown_signal;
+
+    // bumped on every configuration change, builds compare it against the
+    // value they started with and bail out early once they're stale
+    SDL_atomic_t configuration_epoch;
+
+    // terrain_noise calls and fbm octaves sampled by the current build
+    SDL_atomic_t noise_calls;
+    SDL_atomic_t octave_samples;
 
     // used only by the generator thread, no sync required
-    SimplexContext           simplex;
-    uint32_t*                generator_indices;
-    struct vec3*             generator_vertices;
-    struct vec3*             generator_normals;
-    struct generation_params generated_params;
+    SimplexContext                  simplex;
+    int64_t                         simplex_seed;
+    ThreadPool                      workers;
+    uint32_t                        worker_count;
+    uint32_t                        tile_rows;
+    uint32_t                        tile_capacity;
+    struct tile_generation_context* tiles;
+    bool                            shrink_buffers;
+    float*                          heights;
+    bool                            heights_valid;
+    struct generation_params        height_params;
+    uint32_t                        back_mesh;
+    uint32_t                        published_mesh;
+    struct generation_params        generated_params;
+    enum planet_normals             generated_normals;
+
+    // the generator works on structure of arrays copies of the back mesh's
+    // vertices and normals, each tile interleaves its range into the mesh once
+    // the last pass over it is done
+    struct vec3_soa positions;
+    struct vec3_soa normals;
+
+    // vertices the heights, gradients, octave sums, positions and normals
+    // have room for, and the same for the vertices and normals of each mesh
+    size_t vertex_capacity;
+    size_t mesh_capacities[3];
+
+    // wall clock time spent in each pass of the last build
+    float vertex_pass_ms;
+    float normal_pass_ms;
+
+    // the noise gradient at each vertex, kept beside the heights when the
+    // last build used analytic normals
+    struct vec3* gradients;
+    bool         gradients_valid;
+
+    // running fbm sums, octave_sums[layer][vertex] is the sum of layers
+    // [0, layer] for octave_params. Each layer is allocated the first time
+    // it's needed so only the layer counts actually used cost memory.
+    // octave_gradient_sums holds the matching gradient sums while
+    // octave_gradients is set, only for the layers that sample a gradient.
+    bool                     octave_cache;
+    float*                   octave_sums[NOISE_MAX_LAYERS];
+    bool                     octave_gradients;
+    struct vec3*             octave_gradient_sums[NOISE_MAX_LAYERS];
+    uint32_t                 cached_layers;
+    struct generation_params octave_params;
+
+    // every topology built so far until it's evicted, least recently used
+    // first, to keep topology_bytes within topology_budget. The topologies of
+    // the meshes outside the back slot are never evicted, mesh_topologies[slot]
+    // is the topology indexing the mesh in that slot.
+    struct planet_topology** topologies;
+    uint32_t                 topology_count;
+    uint32_t                 topology_capacity;
+    size_t                   topology_bytes;
+    size_t                   topology_budget;
+    uint64_t                 topology_clock;
+    uint64_t                 topology_version;
+    struct planet_topology*  mesh_topologies[3];
+
+    // triple buffered meshes, the generator builds into back_mesh while the
+    // main thread reads front_mesh. Publishing and acquiring swap with the
+    // slot held in ready_mesh so neither side ever waits on the other.
+    struct planet_mesh meshes[3];
+    SDL_atomic_t       ready_mesh;
+
+    // used only by the thread acquiring meshes
+    uint32_t front_mesh;
 
     // available to the main thread, sync required
     uint64_t                 id;
     struct generation_params configured_params;
-    uint32_t                 index_count;
-    uint32_t                 vertex_count;
-    uint32_t*                indices;
-    struct vec3*             vertices;
-    struct vec3*             normals;
+    uint32_t                 configured_worker_count;
+    uint32_t                 configured_tile_rows;
+    bool                     configured_octave_cache;
+    size_t                   configured_topology_budget;
+    bool                     configured_shrink_buffers;
+    enum planet_normals      configured_normals;
+    struct planet_stats      stats;
 };
 
-static bool
-check_shutdown_signal(struct planet* planet)
+// set on ready_mesh alongside the slot index when it holds a mesh the reader
+// hasn't picked up yet
+#define READY_MESH_FRESH 0x4
+#define READY_MESH_SLOT 0x3
+
+// call with the mutex held after modifying configured_params
+static void
+notify_configuration_changed(struct planet* planet)
 {
-    bool result = false;
-#ifdef _WIN32
-    SDL_LockMutex(planet->mutex);
-    result = planet->shutdown_signal != 0;
-    SDL_UnlockMutex(planet->mutex);
-#else
-    result = atomic_load(&planet->shutdown_signal) != 0;
-#endif
-    return result;
+    SDL_AtomicAdd(&planet->configuration_epoch, 1);
+    SDL_CondSignal(planet->generator_wakeup);
 }
 
 static void
 set_shutdown_signal(struct planet* planet)
 {
-#ifdef _WIN32
     SDL_LockMutex(planet->mutex);
-    planet->shutdown_signal = 1;
+    planet->shutdown_signal = true;
+    SDL_CondSignal(planet->generator_wakeup);
     SDL_UnlockMutex(planet->mutex);
-#else
-    atomic_store(&planet->shutdown_signal, 1);
-#endif
 }
 
-struct face_generation_context {
+// the cube is laid out on an integer lattice spanning [0, subdivisions] along
+// each axis, which lets vertices shared by neighbouring faces be matched up
+// exactly rather than by comparing floats
+struct cube_face {
+    int corner[3];
+    int dx[3];
+    int dy[3];
+};
+
+// front, left, back, right, top, bottom
+static const struct cube_face CUBE_FACES[6] = {
+    {.corner = {0, 0, 0}, .dx = {1, 0, 0}, .dy = {0, 1, 0}},
+    {.corner = {0, 0, 1}, .dx = {0, 0, -1}, .dy = {0, 1, 0}},
+    {.corner = {1, 0, 1}, .dx = {-1, 0, 0}, .dy = {0, 1, 0}},
+    {.corner = {1, 0, 0}, .dx = {0, 0, 1}, .dy = {0, 1, 0}},
+    {.corner = {0, 0, 1}, .dx = {1, 0, 0}, .dy = {0, 0, -1}},
+    {.corner = {0, 1, 0}, .dx = {1, 0, 0}, .dy = {0, 0, 1}},
+};
+
+// vertices are stored as the interior of each face in face order, then the
+// interior of each of the 12 cube edges and finally the 8 cube corners so
+// every point on the cube appears exactly once
+static uint32_t
+stitched_vertex_count(uint32_t subdivisions)
+{
+    return 6 * subdivisions * subdivisions + 2;
+}
+
+static uint32_t
+stitched_index_count(uint32_t subdivisions)
+{
+    return subdivisions * subdivisions * 2 * 3 * 6;
+}
+
+static void
+face_lattice_point(
+    uint32_t n, uint32_t face, uint32_t x, uint32_t y, uint32_t lattice[3]
+)
+{
+    const struct cube_face* f = CUBE_FACES + face;
+    for (int k = 0; k < 3; k++) {
+        lattice[k] = (uint32_t)(f->corner[k] * (int)n + f->dx[k] * (int)x +
+                                f->dy[k] * (int)y);
+    }
+}
+
+// inverse of face_lattice_point, false if the point isn't on the face
+static bool
+lattice_face_point(
+    uint32_t n, uint32_t face, const uint32_t lattice[3], uint32_t* x,
+    uint32_t* y
+)
+{
+    const struct cube_face* f = CUBE_FACES + face;
+
+    int face_x = 0;
+    int face_y = 0;
+    for (int k = 0; k < 3; k++) {
+        int offset = (int)lattice[k] - f->corner[k] * (int)n;
+        if (f->dx[k] == 0 && f->dy[k] == 0 && offset != 0) return false;
+        face_x += f->dx[k] * offset;
+        face_y += f->dy[k] * offset;
+    }
+    *x = (uint32_t)face_x;
+    *y = (uint32_t)face_y;
+    return true;
+}
+
+// index of a lattice point that lies on a cube edge or corner
+static uint32_t
+seam_vertex_index(uint32_t n, const uint32_t lattice[3])
+{
+    const uint32_t edge_start   = 6 * (n - 1) * (n - 1);
+    const uint32_t corner_start = edge_start + 12 * (n - 1);
+
+    uint32_t boundary_axes = 0;
+    uint32_t far_axes      = 0;
+    for (uint32_t k = 0; k < 3; k++) {
+        if (lattice[k] == 0 || lattice[k] == n) boundary_axes |= 1u << k;
+        if (lattice[k] == n) far_axes |= 1u << k;
+    }
+    if (boundary_axes == 0x7) return corner_start + far_axes;
+
+    // edges run along the one axis that isn't pinned to the boundary and are
+    // numbered by which side of the other two axes they sit on
+    uint32_t axis = (boundary_axes & 0x1) ? ((boundary_axes & 0x2) ? 2 : 1) : 0;
+    uint32_t edge = axis * 4 + ((lattice[(axis + 1) % 3] == n) ? 1 : 0) +
+                    ((lattice[(axis + 2) % 3] == n) ? 2 : 0);
+    return edge_start + edge * (n - 1) + lattice[axis] - 1;
+}
+
+static uint32_t
+face_vertex_index(uint32_t n, uint32_t face, uint32_t x, uint32_t y)
+{
+    if (x > 0 && x < n && y > 0 && y < n) {
+        return face * (n - 1) * (n - 1) + (y - 1) * (n - 1) + (x - 1);
+    }
+    uint32_t lattice[3];
+    face_lattice_point(n, face, x, y, lattice);
+    return seam_vertex_index(n, lattice);
+}
+
+// false if the vertex lies on a seam and so belongs to more than one face
+static bool
+interior_face_point(
+    uint32_t n, uint32_t vertex, uint32_t* face, uint32_t* x, uint32_t* y
+)
+{
+    if (vertex >= 6 * (n - 1) * (n - 1)) return false;
+    uint32_t face_vertex = vertex % ((n - 1) * (n - 1));
+    *face                = vertex / ((n - 1) * (n - 1));
+    *x                   = face_vertex % (n - 1) + 1;
+    *y                   = face_vertex / (n - 1) + 1;
+    return true;
+}
+
+static void
+vertex_lattice_point(uint32_t n, uint32_t vertex, uint32_t lattice[3])
+{
+    const uint32_t edge_start   = 6 * (n - 1) * (n - 1);
+    const uint32_t corner_start = edge_start + 12 * (n - 1);
+
+    uint32_t face, x, y;
+    if (interior_face_point(n, vertex, &face, &x, &y)) {
+        face_lattice_point(n, face, x, y, lattice);
+    }
+    else if (vertex < corner_start) {
+        uint32_t edge           = (vertex - edge_start) / (n - 1);
+        uint32_t axis           = edge / 4;
+        lattice[axis]           = (vertex - edge_start) % (n - 1) + 1;
+        lattice[(axis + 1) % 3] = (edge & 0x1) ? n : 0;
+        lattice[(axis + 2) % 3] = (edge & 0x2) ? n : 0;
+    }
+    else {
+        uint32_t corner = vertex - corner_start;
+        for (uint32_t k = 0; k < 3; k++) {
+            lattice[k] = (corner & (1u << k)) ? n : 0;
+        }
+    }
+}
+
+// unit sphere direction of a lattice point, the cube is centered on (0,0,0)
+static struct vec3
+lattice_direction(uint32_t n, const uint32_t lattice[3])
+{
+    struct vec3 direction = {
+        (float)lattice[0] / (float)n - 0.5f,
+        (float)lattice[1] / (float)n - 0.5f,
+        (float)lattice[2] / (float)n - 0.5f,
+    };
+    vec3norm(&direction);
+    return direction;
+}
+
+// the vertices sharing a triangle with vertex, sorted counter clockwise around
+// it as seen from outside so consecutive pairs span its triangles. Vertices
+// with fewer than PLANET_MAX_NEIGHBOURS repeat the last one.
+static void
+vertex_neighbours(
+    uint32_t n, uint32_t vertex, uint32_t neighbours[PLANET_MAX_NEIGHBOURS]
+)
+{
+    uint32_t lattice[3];
+    vertex_lattice_point(n, vertex, lattice);
+    const struct vec3 direction = lattice_direction(n, lattice);
+
+    uint32_t    count = 0;
+    float       angles[PLANET_MAX_NEIGHBOURS];
+    struct vec3 u = {0.0f, 0.0f, 0.0f};
+    struct vec3 v = {0.0f, 0.0f, 0.0f};
+    for (uint32_t face = 0; face < 6; face++) {
+        uint32_t x, y;
+        if (!lattice_face_point(n, face, lattice, &x, &y)) continue;
+
+        // each quad is split into (top left, top right, bottom left) and
+        // (top right, bottom right, bottom left), corners listed in that order
+        for (uint32_t quad = 0; quad < 4; quad++) {
+            if ((quad & 0x1) ? x == n : x == 0) continue;
+            if ((quad & 0x2) ? y == n : y == 0) continue;
+            const uint32_t left = (quad & 0x1) ? x : x - 1;
+            const uint32_t top  = (quad & 0x2) ? y : y - 1;
+
+            static const uint32_t TRIANGLES[2][3] = {{0, 1, 2}, {1, 3, 2}};
+            for (uint32_t t = 0; t < 2; t++) {
+                uint32_t corners[3];
+                bool     touches = false;
+                for (uint32_t c = 0; c < 3; c++) {
+                    uint32_t cx = left + (TRIANGLES[t][c] & 0x1);
+                    uint32_t cy = top + (TRIANGLES[t][c] >> 1);
+                    corners[c]  = face_vertex_index(n, face, cx, cy);
+                    if (corners[c] == vertex) touches = true;
+                }
+                if (!touches) continue;
+
+                for (uint32_t c = 0; c < 3; c++) {
+                    bool known = corners[c] == vertex;
+                    for (uint32_t i = 0; i < count; i++) {
+                        if (neighbours[i] == corners[c]) known = true;
+                    }
+                    if (known) continue;
+                    assert(count < PLANET_MAX_NEIGHBOURS);
+
+                    // angles are measured in the tangent plane starting
+                    // from the first neighbour found. Offsets are projected
+                    // onto it first, at low subdivisions their radial part
+                    // is large enough to reorder the fan otherwise.
+                    uint32_t neighbour[3];
+                    vertex_lattice_point(n, corners[c], neighbour);
+                    struct vec3 offset =
+                        vec3sub(lattice_direction(n, neighbour), direction);
+                    offset = vec3sub(
+                        offset,
+                        vec3muls(direction, vec3dot(offset, direction))
+                    );
+                    if (count == 0) {
+                        u = offset;
+                        v = vec3cross(direction, u);
+                    }
+                    float angle =
+                        atan2f(vec3dot(offset, v), vec3dot(offset, u));
+
+                    // insertion sort by angle
+                    uint32_t i = count++;
+                    for (; i > 0 && angles[i - 1] > angle; i--) {
+                        angles[i]     = angles[i - 1];
+                        neighbours[i] = neighbours[i - 1];
+                    }
+                    angles[i]     = angle;
+                    neighbours[i] = corners[c];
+                }
+            }
+        }
+    }
+    for (uint32_t i = count; i < PLANET_MAX_NEIGHBOURS; i++) {
+        neighbours[i] = neighbours[count - 1];
+    }
+}
+
+struct generation_context {
     struct planet*            planet;
     struct generation_params* params;
-    uint32_t                  start_vertex;
-    uint32_t                  start_index;
-    struct vec3               corner;
-    struct vec3               dx;
-    struct vec3               dy;
+    struct planet_mesh*       target;
+    struct planet_topology*   topology;
+    bool                      build_topology;
+    int                       epoch;
+
+    // vertex tiles write normals from the gradient of the first
+    // gradient_layers octaves and the triangle passes are skipped. With
+    // normal_pass set the normals are gathered from the triangles instead
+    // once every vertex is placed.
+    bool     gradients;
+    uint32_t gradient_layers;
+    bool     normal_pass;
+
+    // layers [0, cached_layers) are served from planet->octave_sums and any
+    // beyond that are sampled and appended to it
+    bool              octave_cache;
+    uint32_t          cached_layers;
+    struct fbm_octave octaves[NOISE_MAX_LAYERS];
 };
 
-// if subdivisions have not changed we can avoid regenerating the geometry and
-// just recalculate vertex positions/normals
-static int
-regenerate_face(struct face_generation_context* ctx)
+static bool
+build_is_stale(struct generation_context* ctx)
+{
+    return SDL_AtomicGet(&ctx->planet->configuration_epoch) != ctx->epoch;
+}
+
+// the unit of work handed to the thread pool so the number of tasks (and
+// threads that can help) scales with the subdivision count rather than being
+// capped at the 6 faces. Depending on the task this is either a range of
+// vertices or a band of quad rows within one face.
+struct tile_generation_context {
+    struct generation_context* ctx;
+    uint32_t                   face;
+    uint32_t                   begin;
+    uint32_t                   end;
+};
+
+// the fbm heights of count consecutive vertices starting at first and, if
+// the build needs them, their gradients. Returns the number of octaves
+// sampled for them.
+static uint32_t
+vertex_heights(
+    struct generation_context* ctx,
+    struct vec3_soa            directions,
+    uint32_t                   first,
+    uint32_t                   count,
+    float*                     heights,
+    struct vec3*               gradients
+)
 {
     static const struct vec3 vec3zero = {0.0f, 0.0f, 0.0f};
 
-    const uint32_t vertices_per_face =
-        (ctx->params->subdivisions + 1) * (ctx->params->subdivisions + 1);
-    const uint32_t indices_per_face =
-        ctx->params->subdivisions * ctx->params->subdivisions * 2 * 3;
-
-    for (uint32_t i = ctx->start_vertex;
-         i < ctx->start_vertex + vertices_per_face;
-         i++) {
-        ctx->planet->generator_normals[i] = vec3zero;
-
-        // we're safe to touch these without sync as long as we're only reading
-        struct vec3 vertex = ctx->planet->vertices[i];
-        vec3norm(&vertex);
-        float noise = terrain_noise(
-            ctx->planet->simplex,
-            vertex,
-            ctx->params->noise_layers,
+    struct planet* planet = ctx->planet;
+    const uint32_t layers = ctx->params->noise_layers;
+
+    if (!ctx->octave_cache) {
+        terrain_noise_batch(
+            planet->simplex,
+            directions,
+            count,
+            layers,
             ctx->params->noise_gain,
             ctx->params->noise_frequency,
-            ctx->params->noise_lacunarity
+            ctx->params->noise_lacunarity,
+            heights,
+            gradients,
+            ctx->gradient_layers
+        );
+        return layers * count;
+    }
+
+    // resume from the last cached layer, or from nothing
+    uint32_t resume =
+        (layers < ctx->cached_layers) ? layers : ctx->cached_layers;
+    for (uint32_t i = 0; i < count; i++) {
+        heights[i] =
+            (resume) ? planet->octave_sums[resume - 1][first + i] : 0.0f;
+    }
+    // gradient sums are only kept for the layers that sample a gradient, the
+    // ones above would all repeat the last of them
+    uint32_t gradient_resume =
+        (resume < ctx->gradient_layers) ? resume : ctx->gradient_layers;
+    for (uint32_t i = 0; gradients && i < count; i++) {
+        gradients[i] =
+            (gradient_resume)
+                ? planet->octave_gradient_sums[gradient_resume - 1][first + i]
+                : vec3zero;
+    }
+
+    // octave by octave so each one goes through the batch kernel, the sums
+    // still accumulate in the same order as fbm
+    float       samples[NOISE_BATCH_SIZE];
+    struct vec3 sample_gradients[NOISE_BATCH_SIZE];
+    for (uint32_t layer = resume; layer < layers; layer++) {
+        bool sample_gradient = gradients && layer < ctx->gradient_layers;
+        fbm_octave_sample_batch(
+            planet->simplex,
+            directions,
+            count,
+            ctx->octaves[layer],
+            samples,
+            (sample_gradient) ? sample_gradients : NULL
         );
-        vec3imuls(&vertex, PLANET_RADIUS + noise * ctx->params->noise_scale);
-        ctx->planet->generator_vertices[i] = vertex;
+        float* sums = planet->octave_sums[layer] + first;
+        for (uint32_t i = 0; i < count; i++) {
+            heights[i] += samples[i];
+            sums[i] = heights[i];
+        }
+        if (sample_gradient) {
+            struct vec3* gradient_sums =
+                planet->octave_gradient_sums[layer] + first;
+            for (uint32_t i = 0; i < count; i++) {
+                vec3iadd(gradients + i, sample_gradients[i]);
+                gradient_sums[i] = gradients[i];
+            }
+        }
     }
+    return (layers - resume) * count;
+}
+
+// the normal of the sphere displaced along its radius by noise_scale * height,
+// only the part of the height gradient running along the surface tilts it
+// away from the radial direction
+static struct vec3
+analytic_normal(
+    struct vec3 direction, float height, struct vec3 gradient, float noise_scale
+)
+{
+    float       radius  = PLANET_RADIUS + height * noise_scale;
+    struct vec3 tangent = vec3sub(
+        gradient, vec3muls(direction, vec3dot(gradient, direction))
+    );
+    struct vec3 normal =
+        vec3sub(direction, vec3muls(tangent, noise_scale / radius));
+    vec3norm(&normal);
+    return normal;
+}
 
-    for (uint32_t i = ctx->start_index; i < ctx->start_index + indices_per_face;
-         i += 3) {
-        const uint32_t index_1 = ctx->planet->indices[i + 0];
-        const uint32_t index_2 = ctx->planet->indices[i + 1];
-        const uint32_t index_3 = ctx->planet->indices[i + 2];
+static int16_t
+quantize_snorm16(float value)
+{
+    if (value < -1.0f) value = -1.0f;
+    if (value > 1.0f) value = 1.0f;
+    return (int16_t)lrintf(value * 32767.0f);
+}
 
-        // set indices because the generator buffer might not have these indices
-        // in it yet
-        ctx->planet->generator_indices[i + 0] = index_1;
-        ctx->planet->generator_indices[i + 1] = index_2;
-        ctx->planet->generator_indices[i + 2] = index_3;
+static int8_t
+quantize_snorm8(float value)
+{
+    if (value < -1.0f) value = -1.0f;
+    if (value > 1.0f) value = 1.0f;
+    return (int8_t)lrintf(value * 127.0f);
+}
 
-        struct vec3 vertex_1 = ctx->planet->generator_vertices[index_1];
-        struct vec3 vertex_2 = ctx->planet->generator_vertices[index_2];
-        struct vec3 vertex_3 = ctx->planet->generator_vertices[index_3];
+static uint16_t
+quantize_unorm16(float value)
+{
+    if (value < 0.0f) value = 0.0f;
+    if (value > 1.0f) value = 1.0f;
+    return (uint16_t)lrintf(value * 65535.0f);
+}
 
-        struct vec3 edge1  = vec3sub(vertex_3, vertex_1);
-        struct vec3 edge2  = vec3sub(vertex_2, vertex_1);
-        struct vec3 normal = vec3cross(edge1, edge2);
+// the packed radius spans every radius the noise can produce with params,
+// fbm sums octaves of simplex noise in [-1, 1] scaled by their amplitudes
+static void
+packed_radius_range(
+    const struct generation_params* params, float* radius_min, float* radius_max
+)
+{
+    float amplitude = 0.0f;
+    for (uint32_t layer = 0; layer < params->noise_layers; layer++) {
+        struct fbm_octave octave = fbm_octave(
+            layer,
+            params->noise_gain,
+            params->noise_frequency,
+            params->noise_lacunarity
+        );
+        amplitude += octave.amplitude;
+    }
+    *radius_min = PLANET_RADIUS - amplitude * params->noise_scale;
+    *radius_max = PLANET_RADIUS + amplitude * params->noise_scale;
+}
 
-        vec3iadd(ctx->planet->generator_normals + index_1, normal);
-        vec3iadd(ctx->planet->generator_normals + index_2, normal);
-        vec3iadd(ctx->planet->generator_normals + index_3, normal);
+static void
+pack_vertices(struct generation_context* ctx, uint32_t begin, uint32_t end)
+{
+    const struct vec3_soa directions = ctx->topology->directions;
+    const struct vec3_soa normals    = ctx->planet->normals;
+    const float*          heights    = ctx->planet->heights;
+    const float           scale      = ctx->params->noise_scale;
+    const float           radius_min = ctx->target->radius_min;
+    const float           radius_range =
+        ctx->target->radius_max - ctx->target->radius_min;
+
+    struct planet_packed_vertex* packed = ctx->target->packed_vertices;
+    for (uint32_t i = begin; i < end; i++) {
+        float direction[2], normal[2];
+        vec3_octahedral_encode(vec3_soa_get(directions, i), direction);
+        vec3_octahedral_encode(vec3_soa_get(normals, i), normal);
+
+        const float radius   = PLANET_RADIUS + heights[i] * scale;
+        const float fraction = (radius - radius_min) / radius_range;
+
+        packed[i].direction[0] = quantize_snorm16(direction[0]);
+        packed[i].direction[1] = quantize_snorm16(direction[1]);
+        packed[i].radius       = quantize_unorm16(fraction);
+        packed[i].normal[0]    = quantize_snorm8(normal[0]);
+        packed[i].normal[1]    = quantize_snorm8(normal[1]);
     }
+}
 
-    for (uint32_t i = ctx->start_vertex;
-         i < ctx->start_vertex + vertices_per_face;
-         i++) {
-        vec3norm(ctx->planet->generator_normals + i);
+// copies [begin, end) of the generator's vertices and normals into the
+// vertex format of the mesh being built
+static void
+interleave_vertices(
+    struct generation_context* ctx, uint32_t begin, uint32_t end
+)
+{
+    if (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_PACKED) {
+        pack_vertices(ctx, begin, end);
+        return;
+    }
+    if (HEIGHT_VERTICES) {
+        const float* heights = ctx->planet->heights;
+        const float  scale   = ctx->params->noise_scale;
+        for (uint32_t i = begin; i < end; i++) {
+            ctx->target->radii[i] = PLANET_RADIUS + heights[i] * scale;
+        }
+        return;
     }
 
-    return 0;
+    const struct vec3_soa positions = ctx->planet->positions;
+    const struct vec3_soa normals   = ctx->planet->normals;
+
+    struct vec3* vertices       = ctx->target->vertices;
+    struct vec3* target_normals = ctx->target->normals;
+    for (uint32_t i = begin; i < end; i++) {
+        vertices[i]       = vec3_soa_get(positions, i);
+        target_normals[i] = vec3_soa_get(normals, i);
+    }
 }
 
-static int
-construct_subdivided_face(struct face_generation_context* ctx)
+static void
+construct_vertex_tile(struct tile_generation_context* tile)
 {
-    static const struct vec3 vec3zero = {0.0f, 0.0f, 0.0f};
+    struct generation_context* ctx = tile->ctx;
+
+    const uint32_t        n          = ctx->params->subdivisions;
+    const float           scale      = ctx->params->noise_scale;
+    const struct vec3_soa positions  = ctx->planet->positions;
+    const struct vec3_soa normals    = ctx->planet->normals;
+    const struct vec3_soa directions = ctx->topology->directions;
+
+    float       heights[NOISE_BATCH_SIZE];
+    struct vec3 gradients[NOISE_BATCH_SIZE];
+
+    uint32_t noise_calls    = 0;
+    uint32_t octave_samples = 0;
+    for (uint32_t first = tile->begin; first < tile->end;
+         first += NOISE_BATCH_SIZE) {
+        if (build_is_stale(ctx)) break;
+
+        uint32_t count = tile->end - first;
+        if (count > NOISE_BATCH_SIZE) count = NOISE_BATCH_SIZE;
+
+        // derived from the lattice once per topology rather than from the
+        // previous mesh so cached octaves are resumed at exactly the
+        // location they were sampled at
+        for (uint32_t i = 0; ctx->build_topology && i < count; i++) {
+            uint32_t lattice[3];
+            vertex_lattice_point(n, first + i, lattice);
+            vec3_soa_set(directions, first + i, lattice_direction(n, lattice));
+            if (HEIGHT_VERTICES) {
+                vertex_neighbours(
+                    n,
+                    first + i,
+                    ctx->topology->neighbours +
+                        (first + i) * PLANET_MAX_NEIGHBOURS
+                );
+            }
+        }
 
-    // construct vertices
-    for (uint32_t y = 0; y < ctx->params->subdivisions + 1; y++) {
-        for (uint32_t x = 0; x < ctx->params->subdivisions + 1; x++) {
-            struct vec3 vertex = ctx->corner;
-            vertex.x += ctx->dx.x * (float)x;
-            vertex.y += ctx->dx.y * (float)x;
-            vertex.z += ctx->dx.z * (float)x;
-            vertex.x += ctx->dy.x * (float)y;
-            vertex.y += ctx->dy.y * (float)y;
-            vertex.z += ctx->dy.z * (float)y;
-            // assumes the caller is responsible for centering the cube about
-            // (0,0,0)
-            vec3norm(&vertex);
-            float noise = terrain_noise(
-                ctx->planet->simplex,
-                vertex,
-                ctx->params->noise_layers,
-                ctx->params->noise_gain,
-                ctx->params->noise_frequency,
-                ctx->params->noise_lacunarity
-            );
-            vec3imuls(
-                &vertex, PLANET_RADIUS + noise * ctx->params->noise_scale
+        uint32_t samples = vertex_heights(
+            ctx,
+            vec3_soa_offset(directions, first),
+            first,
+            count,
+            heights,
+            (ctx->gradients) ? gradients : NULL
+        );
+        if (samples) noise_calls += count;
+        octave_samples += samples;
+
+        // height meshes are built from the heights alone, nothing reads the
+        // positions
+        if (!HEIGHT_VERTICES) {
+            const float* direction_x = directions.x + first;
+            const float* direction_y = directions.y + first;
+            const float* direction_z = directions.z + first;
+            float*       x           = positions.x + first;
+            float*       y           = positions.y + first;
+            float*       z           = positions.z + first;
+            for (uint32_t i = 0; i < count; i++) {
+                const float radius = PLANET_RADIUS + heights[i] * scale;
+                x[i]               = direction_x[i] * radius;
+                y[i]               = direction_y[i] * radius;
+                z[i]               = direction_z[i] * radius;
+            }
+        }
+        memcpy(ctx->planet->heights + first, heights, count * sizeof *heights);
+        for (uint32_t i = 0; ctx->gradients && i < count; i++) {
+            vec3_soa_set(
+                normals,
+                first + i,
+                analytic_normal(
+                    vec3_soa_get(directions, first + i),
+                    heights[i],
+                    gradients[i],
+                    scale
+                )
             );
-
-            uint32_t vertex_index =
-                ctx->start_vertex + y * (ctx->params->subdivisions + 1) + x;
-            ctx->planet->generator_vertices[vertex_index] = vertex;
-            ctx->planet->generator_normals[vertex_index]  = vec3zero;
+            ctx->planet->gradients[first + i] = gradients[i];
         }
     }
+    SDL_AtomicAdd(&ctx->planet->noise_calls, (int)noise_calls);
+    SDL_AtomicAdd(&ctx->planet->octave_samples, (int)octave_samples);
+
+    // the normal pass interleaves once it has gathered the normals, otherwise
+    // they're already final
+    if (!ctx->normal_pass && !build_is_stale(ctx))
+        interleave_vertices(ctx, tile->begin, tile->end);
+}
+
+// only the noise scale changed so the heights cached by the last build are
+// still good, no noise needs to be evaluated
+static void
+rescale_vertex_tile(struct tile_generation_context* tile)
+{
+    struct generation_context* ctx = tile->ctx;
+
+    const uint32_t        n          = ctx->params->subdivisions;
+    const float           scale      = ctx->params->noise_scale;
+    const struct vec3_soa positions  = ctx->planet->positions;
+    const struct vec3_soa normals    = ctx->planet->normals;
+    const struct vec3_soa directions = ctx->topology->directions;
+
+    // height meshes only need the radii interleave_vertices derives from the
+    // cached heights
+    for (uint32_t i = tile->begin; !HEIGHT_VERTICES && i < tile->end; i++) {
+        if ((i - tile->begin) % (n + 1) == 0 && build_is_stale(ctx)) return;
+
+        struct vec3 direction = vec3_soa_get(directions, i);
+        float       height    = ctx->planet->heights[i];
+        vec3_soa_set(
+            positions, i, vec3muls(direction, PLANET_RADIUS + height * scale)
+        );
+        if (ctx->gradients)
+            vec3_soa_set(
+                normals,
+                i,
+                analytic_normal(
+                    direction, height, ctx->planet->gradients[i], scale
+                )
+            );
+    }
+    if (!ctx->normal_pass) interleave_vertices(ctx, tile->begin, tile->end);
+}
+
+static void
+construct_index_tile(struct tile_generation_context* tile)
+{
+    struct generation_context* ctx = tile->ctx;
+
+    const uint32_t n       = ctx->params->subdivisions;
+    const uint32_t face    = tile->face;
+    uint32_t*      indices = ctx->topology->indices;
+
+    for (uint32_t y = tile->begin; y < tile->end; y++) {
+        if (build_is_stale(ctx)) return;
+        uint32_t index = face * n * n * 2 * 3 + y * n * 2 * 3;
+        for (uint32_t x = 0; x < n; x++) {
+            const uint32_t top_left     = face_vertex_index(n, face, x, y);
+            const uint32_t top_right    = face_vertex_index(n, face, x + 1, y);
+            const uint32_t bottom_left  = face_vertex_index(n, face, x, y + 1);
+            const uint32_t bottom_right =
+                face_vertex_index(n, face, x + 1, y + 1);
 
-    // clang-format off
-    // accumulate normals and construct indices
-    for (uint32_t y = 0; y < ctx->params->subdivisions; y++) {
-        for (uint32_t x = 0; x < ctx->params->subdivisions; x++) {
             // first triangle
-            //
-            // indices
-            uint32_t vertex_index_1 = ctx->start_vertex + y * (ctx->params->subdivisions + 1) + x;
-            uint32_t vertex_index_2 = ctx->start_vertex + y * (ctx->params->subdivisions + 1) + x + 1;
-            uint32_t vertex_index_3 = ctx->start_vertex + (y + 1) * (ctx->params->subdivisions + 1) + x;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_1;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_2;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_3;
-
-            // normals
-            struct vec3 vertex_1 = ctx->planet->generator_vertices[vertex_index_1];
-            struct vec3 vertex_2 = ctx->planet->generator_vertices[vertex_index_2];
-            struct vec3 vertex_3 = ctx->planet->generator_vertices[vertex_index_3];
-
-            struct vec3 edge1 = vec3sub(vertex_3, vertex_1);
-            struct vec3 edge2 = vec3sub(vertex_2, vertex_1);
-            struct vec3 normal = vec3cross(edge1, edge2);
-
-            vec3iadd(ctx->planet->generator_normals+vertex_index_1, normal);
-            vec3iadd(ctx->planet->generator_normals+vertex_index_2, normal);
-            vec3iadd(ctx->planet->generator_normals+vertex_index_3, normal);
+            indices[index++] = top_left;
+            indices[index++] = top_right;
+            indices[index++] = bottom_left;
 
             // second triangle
-            //
-            // indices
-            vertex_index_1 = ctx->start_vertex + y * (ctx->params->subdivisions + 1) + x + 1;
-            vertex_index_2 = ctx->start_vertex + (y + 1) * (ctx->params->subdivisions + 1) + x + 1;
-            vertex_index_3 = ctx->start_vertex + (y + 1) * (ctx->params->subdivisions + 1) + x;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_1;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_2;
-            ctx->planet->generator_indices[ctx->start_index++] = vertex_index_3;
-
-            // normals
-            vertex_1 = ctx->planet->generator_vertices[vertex_index_1];
-            vertex_2 = ctx->planet->generator_vertices[vertex_index_2];
-            vertex_3 = ctx->planet->generator_vertices[vertex_index_3];
-            edge1 = vec3sub(vertex_3, vertex_1);
-            edge2 = vec3sub(vertex_2, vertex_1);
-            normal = vec3cross(edge1, edge2);
-            vec3iadd(ctx->planet->generator_normals+vertex_index_1, normal);
-            vec3iadd(ctx->planet->generator_normals+vertex_index_2, normal);
-            vec3iadd(ctx->planet->generator_normals+vertex_index_3, normal);
+            indices[index++] = top_right;
+            indices[index++] = bottom_right;
+            indices[index++] = bottom_left;
         }
     }
-    // clang-format on
+}
 
-    // normalize accumulated normals
-    for (uint32_t i = 0;
-         i < (ctx->params->subdivisions + 1) * (ctx->params->subdivisions + 1);
-         i++) {
-        vec3norm(ctx->planet->generator_normals + i);
+// vertex indices of the 3x3 block of face points centered on (x, y), points
+// beyond the face's edges are left untouched
+static void
+face_neighbourhood(
+    uint32_t n, uint32_t face, uint32_t x, uint32_t y, uint32_t block[3][3]
+)
+{
+    for (uint32_t dy = 0; dy < 3; dy++) {
+        for (uint32_t dx = 0; dx < 3; dx++) {
+            if (x + dx < 1 || x + dx > n + 1 || y + dy < 1 || y + dy > n + 1)
+                continue;
+            block[dy][dx] = face_vertex_index(n, face, x + dx - 1, y + dy - 1);
+        }
     }
+}
 
-    return 0;
+// the sum of the area weighted normals of the triangles of one face that touch
+// the face point (x, y). Each quad is split into (top left, top right,
+// bottom left) and (top right, bottom right, bottom left), so the vertex
+// belongs to 1 or 2 triangles of each of the up to 4 quads around it. Every
+// triangle has the vertex as a corner so its normal is the cross product of
+// the two edges leaving the vertex. The two triangles of a quad share the
+// diagonal edge so their normals sum to a single cross product.
+static struct vec3
+gather_face_normal(
+    struct vec3_soa positions, uint32_t n, uint32_t face, uint32_t x, uint32_t y
+)
+{
+    uint32_t block[3][3];
+    face_neighbourhood(n, face, x, y, block);
+
+    const struct vec3 center = vec3_soa_get(positions, block[1][1]);
+    struct vec3       edges[3][3];
+    for (uint32_t dy = 0; dy < 3; dy++) {
+        for (uint32_t dx = 0; dx < 3; dx++) {
+            if (x + dx < 1 || x + dx > n + 1 || y + dy < 1 || y + dy > n + 1)
+                continue;
+            edges[dy][dx] =
+                vec3sub(vec3_soa_get(positions, block[dy][dx]), center);
+        }
+    }
+
+    struct vec3 normal = {0.0f, 0.0f, 0.0f};
+    if (x < n && y < n) {
+        // top left of the quad below and to the right
+        vec3iadd(&normal, vec3cross(edges[2][1], edges[1][2]));
+    }
+    if (x > 0 && y < n) {
+        // top right and bottom right of the quad below and to the left
+        vec3iadd(
+            &normal,
+            vec3cross(edges[2][0], vec3sub(edges[2][1], edges[1][0]))
+        );
+    }
+    if (x < n && y > 0) {
+        // top left and bottom left of the quad above and to the right
+        vec3iadd(
+            &normal,
+            vec3cross(edges[0][2], vec3sub(edges[0][1], edges[1][2]))
+        );
+    }
+    if (x > 0 && y > 0) {
+        // bottom right of the quad above and to the left
+        vec3iadd(&normal, vec3cross(edges[0][1], edges[1][0]));
+    }
+    return normal;
 }
 
+// the edge from vertex a to vertex b
+static struct vec3
+position_edge(
+    const float* x, const float* y, const float* z, size_t a, size_t b
+)
+{
+    return (struct vec3){x[b] - x[a], y[b] - y[a], z[b] - z[a]};
+}
+
+// a x b + c x d, spelled out rather than calling vec3cross so the loop in
+// gather_interior_normals inlines it and vectorizes
+static struct vec3
+cross_sum(struct vec3 a, struct vec3 b, struct vec3 c, struct vec3 d)
+{
+    return (struct vec3){
+        (a.y * b.z - a.z * b.y) + (c.y * d.z - c.z * d.y),
+        (a.z * b.x - a.x * b.z) + (c.z * d.x - c.x * d.z),
+        (a.x * b.y - a.y * b.x) + (c.x * d.y - c.y * d.x),
+    };
+}
+
+// gather_face_normal for count consecutive vertices starting at first that
+// lie on one face row and are all at least two steps from the face's edges,
+// so every neighbour is a fixed stride away. Normals are left unnormalized.
+// The components are passed as restrict pointers, without them the loop needs
+// too many runtime alias checks to vectorize.
+static void
+gather_interior_normals(
+    const float* restrict x,
+    const float* restrict y,
+    const float* restrict z,
+    uint32_t              n,
+    uint32_t              first,
+    uint32_t              count,
+    float* restrict       normal_x,
+    float* restrict       normal_y,
+    float* restrict       normal_z
+)
+{
+    const size_t row = n - 1;
+    for (size_t i = first; i < (size_t)first + count; i++) {
+        struct vec3 right       = position_edge(x, y, z, i, i + 1);
+        struct vec3 below       = position_edge(x, y, z, i, i + row);
+        struct vec3 left        = position_edge(x, y, z, i, i - 1);
+        struct vec3 above       = position_edge(x, y, z, i, i - row);
+        struct vec3 above_right = position_edge(x, y, z, i, i - row + 1);
+        struct vec3 below_left  = position_edge(x, y, z, i, i + row - 1);
+
+        // the same four cross products as gather_face_normal
+        struct vec3 left_to_below = {
+            below.x - left.x,
+            below.y - left.y,
+            below.z - left.z,
+        };
+        struct vec3 right_to_above = {
+            above.x - right.x,
+            above.y - right.y,
+            above.z - right.z,
+        };
+        struct vec3 a = cross_sum(below, right, above, left);
+        struct vec3 b = cross_sum(
+            below_left, left_to_below, above_right, right_to_above
+        );
+        normal_x[i] = a.x + b.x;
+        normal_y[i] = a.y + b.y;
+        normal_z[i] = a.z + b.z;
+    }
+}
+
+// vec3norm over count consecutive normals starting at first
 static void
+normalize_normals(struct vec3_soa normals, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++) {
+        float magnitude = (float)sqrt(
+            normals.x[i] * normals.x[i] + normals.y[i] * normals.y[i] +
+            normals.z[i] * normals.z[i]
+        );
+        if (magnitude == 0) continue;
+        normals.x[i] /= magnitude;
+        normals.y[i] /= magnitude;
+        normals.z[i] /= magnitude;
+    }
+}
+
+// runs once every vertex has been written since the triangles around a vertex
+// straddle tile boundaries. Each vertex gathers the triangles around it rather
+// than triangles scattering into their vertices, so tiles only write their own
+// normals. Seam vertices gather from every face they touch so lighting is
+// continuous across them.
+static void
+gather_normals_tile(struct tile_generation_context* tile)
+{
+    struct generation_context* ctx = tile->ctx;
+
+    const uint32_t        n         = ctx->params->subdivisions;
+    const struct vec3_soa positions = ctx->planet->positions;
+    const struct vec3_soa normals   = ctx->planet->normals;
+
+    for (uint32_t i = tile->begin; i < tile->end;) {
+        if (build_is_stale(ctx)) return;
+
+        uint32_t face, x, y;
+        uint32_t count    = 1;
+        bool     interior = interior_face_point(n, i, &face, &x, &y);
+        if (interior && x >= 2 && x + 2 <= n && y >= 2 && y + 2 <= n) {
+            // the rest of the row that is clear of the face's edges
+            count = n - 1 - x;
+            if (count > tile->end - i) count = tile->end - i;
+            gather_interior_normals(
+                positions.x,
+                positions.y,
+                positions.z,
+                n,
+                i,
+                count,
+                normals.x,
+                normals.y,
+                normals.z
+            );
+        }
+        else if (interior) {
+            vec3_soa_set(
+                normals, i, gather_face_normal(positions, n, face, x, y)
+            );
+        }
+        else {
+            uint32_t lattice[3];
+            vertex_lattice_point(n, i, lattice);
+            struct vec3 normal = {0.0f, 0.0f, 0.0f};
+            for (face = 0; face < 6; face++) {
+                if (lattice_face_point(n, face, lattice, &x, &y))
+                    vec3iadd(
+                        &normal, gather_face_normal(positions, n, face, x, y)
+                    );
+            }
+            vec3_soa_set(normals, i, normal);
+        }
+        normalize_normals(normals, i, count);
+        i += count;
+    }
+    interleave_vertices(ctx, tile->begin, tile->end);
+}
+
+// octaves with features finer than the spacing between vertices can't be
+// represented by the mesh and their gradients would swamp analytic normals
+// with noise, so only the octaves before them contribute. Directions are
+// spaced at most 2 / subdivisions apart and a simplex feature spans about one
+// unit of noise space.
+static uint32_t
+resolvable_layers(const struct generation_params* params)
+{
+    const float max_scale = (float)params->subdivisions / PLANET_NORMAL_DETAIL;
+
+    uint32_t layers = 0;
+    while (layers < params->noise_layers &&
+           fbm_octave(
+               layers,
+               params->noise_gain,
+               params->noise_frequency,
+               params->noise_lacunarity
+           )
+                   .location_scale <= max_scale) {
+        layers++;
+    }
+    return layers;
+}
+
+static float
+elapsed_ms(uint64_t start, uint64_t end)
+{
+    return (float)(end - start) * 1000.0f /
+           (float)SDL_GetPerformanceFrequency();
+}
+
+// returns false if the build was abandoned because the configuration changed
+// while it was running, the generator buffers are left in an undefined state.
+// The topology's indices and directions are built alongside the vertices if
+// build_topology is set, otherwise they are read from it as they are.
+static bool
 construct_subdivided_cube(
     struct planet*            planet,
     struct generation_params* params,
-    bool                      generate_geometry
+    int                       epoch,
+    struct planet_topology*   topology,
+    bool                      build_topology,
+    bool                      reuse_heights,
+    enum planet_normals       normals
 )
 {
-    static const float half_scale = PLANET_RADIUS / 2.0f;
-    const float        interval   = PLANET_RADIUS / (float)params->subdivisions;
-
-    const uint32_t vertices_per_face =
-        (params->subdivisions + 1) * (params->subdivisions + 1);
-    const uint32_t indices_per_face =
-        params->subdivisions * params->subdivisions * 2 * 3;
-
-    SDL_ThreadFunction thread_main =
-        (generate_geometry) ? (SDL_ThreadFunction)construct_subdivided_face
-                            : (SDL_ThreadFunction)regenerate_face;
-    SDL_Thread* threads[6];
-
-    struct face_generation_context front_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 0 * vertices_per_face,
-        .start_index  = 0 * indices_per_face,
-        .corner       = (struct vec3){-half_scale, -half_scale, -half_scale},
-        .dx           = (struct vec3){interval, 0.0f, 0.0f},
-        .dy           = (struct vec3){0.0f, interval, 0.0f},
-    };
-    threads[0] =
-        SDL_CreateThread(thread_main, "front face thread", &front_face_context);
-
-    struct face_generation_context left_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 1 * vertices_per_face,
-        .start_index  = 1 * indices_per_face,
-        .corner       = (struct vec3){-half_scale, -half_scale, half_scale},
-        .dx           = (struct vec3){0.0f, 0.0f, -interval},
-        .dy           = (struct vec3){0.0f, interval, 0.0f},
-    };
-    threads[1] =
-        SDL_CreateThread(thread_main, "left face thread", &left_face_context);
-
-    struct face_generation_context back_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 2 * vertices_per_face,
-        .start_index  = 2 * indices_per_face,
-        .corner       = (struct vec3){half_scale, -half_scale, half_scale},
-        .dx           = (struct vec3){-interval, 0.0f, 0.0f},
-        .dy           = (struct vec3){0.0f, interval, 0.0f},
-    };
-    threads[2] =
-        SDL_CreateThread(thread_main, "back face thread", &back_face_context);
-
-    struct face_generation_context right_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 3 * vertices_per_face,
-        .start_index  = 3 * indices_per_face,
-        .corner       = (struct vec3){half_scale, -half_scale, -half_scale},
-        .dx           = (struct vec3){0.0f, 0.0f, interval},
-        .dy           = (struct vec3){0.0f, interval, 0.0f},
+    struct generation_context ctx = {
+        .planet         = planet,
+        .params         = params,
+        .target         = planet->meshes + planet->back_mesh,
+        .topology       = topology,
+        .build_topology = build_topology,
+        .epoch          = epoch,
+
+        .gradients   = !HEIGHT_VERTICES && normals == PLANET_NORMALS_ANALYTIC,
+        .normal_pass = !HEIGHT_VERTICES && normals == PLANET_NORMALS_TRIANGLES,
+        .gradient_layers = resolvable_layers(params),
+
+        .octave_cache  = planet->octave_cache,
+        .cached_layers = planet->cached_layers,
     };
-    threads[3] =
-        SDL_CreateThread(thread_main, "right face thread", &right_face_context);
-
-    struct face_generation_context top_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 4 * vertices_per_face,
-        .start_index  = 4 * indices_per_face,
-        .corner       = (struct vec3){-half_scale, -half_scale, half_scale},
-        .dx           = (struct vec3){interval, 0.0f, 0.0f},
-        .dy           = (struct vec3){0.0f, 0.0f, -interval},
-    };
-    threads[4] =
-        SDL_CreateThread(thread_main, "top face thread", &top_face_context);
-
-    struct face_generation_context bottom_face_context = {
-        .planet       = planet,
-        .params       = params,
-        .start_vertex = 5 * vertices_per_face,
-        .start_index  = 5 * indices_per_face,
-        .corner       = (struct vec3){-half_scale, half_scale, -half_scale},
-        .dx           = (struct vec3){interval, 0.0f, 0.0f},
-        .dy           = (struct vec3){0.0f, 0.0f, interval},
-    };
-    threads[5] = SDL_CreateThread(
-        thread_main, "bottom face thread", &bottom_face_context
+    packed_radius_range(
+        params, &ctx.target->radius_min, &ctx.target->radius_max
+    );
+    if (ctx.octave_cache) {
+        for (uint32_t layer = 0; layer < params->noise_layers; layer++) {
+            ctx.octaves[layer] = fbm_octave(
+                layer,
+                params->noise_gain,
+                params->noise_frequency,
+                params->noise_lacunarity
+            );
+        }
+    }
+
+    ThreadPoolTask vertex_task = (reuse_heights)
+                                     ? (ThreadPoolTask)rescale_vertex_tile
+                                     : (ThreadPoolTask)construct_vertex_tile;
+
+    const uint32_t n                 = params->subdivisions;
+    const uint32_t tile_rows         = planet->tile_rows;
+    const uint32_t vertex_count      = stitched_vertex_count(n);
+    const uint32_t vertices_per_tile = tile_rows * (n + 1);
+    const uint32_t vertex_tiles =
+        (vertex_count + vertices_per_tile - 1) / vertices_per_tile;
+    const uint32_t index_tiles_per_face = (n + tile_rows - 1) / tile_rows;
+    const uint32_t tile_count = vertex_tiles + index_tiles_per_face * 6;
+
+    if (tile_count > planet->tile_capacity) {
+        free(planet->tiles);
+        planet->tiles = malloc(tile_count * sizeof *planet->tiles);
+        if (planet->tiles == NULL) {
+            fprintf(stderr, "ERROR: failed to allocate generation tiles\n");
+            exit(EXIT_FAILURE);
+        }
+        planet->tile_capacity = tile_count;
+    }
+
+    struct tile_generation_context* vertex_tile_list = planet->tiles;
+    struct tile_generation_context* index_tile_list =
+        vertex_tile_list + vertex_tiles;
+
+    uint64_t pass_start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < vertex_tiles; i++) {
+        struct tile_generation_context* tile = vertex_tile_list + i;
+        tile->ctx                            = &ctx;
+        tile->begin                          = i * vertices_per_tile;
+        tile->end                            = tile->begin + vertices_per_tile;
+        if (tile->end > vertex_count) tile->end = vertex_count;
+        thread_pool_submit(planet->workers, vertex_task, tile);
+    }
+    for (uint32_t face = 0; build_topology && face < 6; face++) {
+        for (uint32_t i = 0; i < index_tiles_per_face; i++) {
+            struct tile_generation_context* tile =
+                index_tile_list + face * index_tiles_per_face + i;
+            tile->ctx   = &ctx;
+            tile->face  = face;
+            tile->begin = i * tile_rows;
+            tile->end   = tile->begin + tile_rows;
+            if (tile->end > n) tile->end = n;
+            thread_pool_submit(
+                planet->workers, (ThreadPoolTask)construct_index_tile, tile
+            );
+        }
+    }
+    thread_pool_wait(planet->workers);
+    uint64_t vertex_pass_end = SDL_GetPerformanceCounter();
+    planet->vertex_pass_ms   = elapsed_ms(pass_start, vertex_pass_end);
+    planet->normal_pass_ms   = 0.0f;
+    if (build_is_stale(&ctx)) return false;
+
+    // analytic normals were already written alongside the vertices
+    if (!ctx.normal_pass) return true;
+
+    for (uint32_t i = 0; i < vertex_tiles; i++) {
+        thread_pool_submit(
+            planet->workers,
+            (ThreadPoolTask)gather_normals_tile,
+            vertex_tile_list + i
+        );
+    }
+
+    // the context lives on this stack frame so the tiles must be finished
+    // before returning
+    thread_pool_wait(planet->workers);
+    planet->normal_pass_ms =
+        elapsed_ms(vertex_pass_end, SDL_GetPerformanceCounter());
+    return !build_is_stale(&ctx);
+}
+
+// true if the heights generated for a would also be generated for b, that is
+// they differ in noise scale at most
+static bool
+heights_match(struct generation_params a, struct generation_params b)
+{
+    a.noise_scale = b.noise_scale;
+    return memcmp(&a, &b, sizeof a) == 0;
+}
+
+// true if the octaves sampled for a would also be sampled for b, that is they
+// differ in noise layers or scale at most
+static bool
+octaves_match(struct generation_params a, struct generation_params b)
+{
+    a.noise_layers = b.noise_layers;
+    a.noise_scale  = b.noise_scale;
+    return memcmp(&a, &b, sizeof a) == 0;
+}
+
+static void
+release_octave_cache(struct planet* planet)
+{
+    for (uint32_t layer = 0; layer < NOISE_MAX_LAYERS; layer++) {
+        free(planet->octave_sums[layer]);
+        free(planet->octave_gradient_sums[layer]);
+        planet->octave_sums[layer]          = NULL;
+        planet->octave_gradient_sums[layer] = NULL;
+    }
+    planet->cached_layers    = 0;
+    planet->octave_gradients = false;
+}
+
+// decides whether the next build goes through the octave cache and makes sure
+// it has room for every layer of params, and for the gradients of the layers
+// that sample one if needed
+static void
+prepare_octave_cache(
+    struct planet*            planet,
+    struct generation_params* params,
+    bool                      enabled,
+    bool                      gradients
+)
+{
+    if (!enabled) release_octave_cache(planet);
+    planet->octave_cache =
+        enabled && params->noise_layers <= NOISE_MAX_LAYERS;
+    if (!planet->octave_cache) return;
+
+    // the sums are about to be overwritten from the first layer up, that
+    // includes gradient sums which builds without gradients left stale
+    if (!octaves_match(*params, planet->octave_params) ||
+        (gradients && !planet->octave_gradients)) {
+        planet->cached_layers = 0;
+        planet->octave_params = *params;
+    }
+    planet->octave_gradients = gradients;
+
+    const uint32_t gradient_layers =
+        (gradients) ? resolvable_layers(params) : 0;
+    for (uint32_t layer = 0; layer < params->noise_layers; layer++) {
+        bool gradient = layer < gradient_layers;
+        if (!planet->octave_sums[layer])
+            planet->octave_sums[layer] = malloc(
+                planet->vertex_capacity * sizeof *planet->octave_sums[layer]
+            );
+        if (gradient && !planet->octave_gradient_sums[layer])
+            planet->octave_gradient_sums[layer] = malloc(
+                planet->vertex_capacity * sizeof(struct vec3)
+            );
+        if (planet->octave_sums[layer] == NULL ||
+            (gradient && planet->octave_gradient_sums[layer] == NULL)) {
+            fprintf(stderr, "ERROR: failed to allocate octave cache\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// the capacity a buffer holding capacity elements should be given to hold
+// needed elements under the growth policy of PLANET_DEFAULT_SHRINK_BUFFERS,
+// never more than limit
+static size_t
+buffer_capacity(size_t capacity, size_t needed, size_t limit, bool shrink)
+{
+    if (needed > capacity) {
+        // doubling the elements only grows the subdivisions by about 1.4x,
+        // but that still keeps a slider sweep to a handful of reallocations
+        size_t grown = (capacity > limit / 2) ? limit : capacity * 2;
+        return (grown > needed) ? grown : needed;
+    }
+    if (shrink && needed < capacity / PLANET_SHRINK_FACTOR) return needed;
+    return capacity;
+}
+
+// makes room for vertex_count vertices in the generator's buffers and the back
+// mesh, call before prepare_octave_cache
+static void
+reserve_vertex_buffers(struct planet* planet, size_t vertex_count)
+{
+    const bool shrink   = planet->shrink_buffers;
+    size_t     capacity = buffer_capacity(
+        planet->vertex_capacity, vertex_count, PLANET_MAX_VERTICES, shrink
     );
+    if (capacity != planet->vertex_capacity) {
+        // heights and gradients are only reused by builds with the same
+        // subdivisions, so the part realloc keeps is all they need
+        float* heights = realloc(planet->heights, capacity * sizeof *heights);
+        if (heights == NULL) goto memory_error;
+        planet->heights = heights;
+
+        // height meshes are interleaved straight from the heights and never
+        // have gradients, positions or normals
+        if (!HEIGHT_VERTICES) {
+            struct vec3* gradients =
+                realloc(planet->gradients, capacity * sizeof *gradients);
+            if (gradients == NULL) goto memory_error;
+            planet->gradients = gradients;
+
+            vec3_soa_destroy(planet->positions);
+            vec3_soa_destroy(planet->normals);
+            planet->positions = vec3_soa_create(capacity);
+            planet->normals   = vec3_soa_create(capacity);
+            if (!planet->positions.x || !planet->normals.x) goto memory_error;
+        }
+
+        // reallocated at the new capacity as the layers are needed again
+        release_octave_cache(planet);
+        planet->vertex_capacity = capacity;
+    }
+
+    // only the back mesh belongs to the generator, the others catch up once
+    // they are handed back to it
+    const uint32_t      slot = planet->back_mesh;
+    struct planet_mesh* mesh = planet->meshes + slot;
+    capacity                 = buffer_capacity(
+        planet->mesh_capacities[slot], vertex_count, PLANET_MAX_VERTICES, shrink
+    );
+    if (capacity != planet->mesh_capacities[slot]) {
+        if (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_PACKED) {
+            free(mesh->packed_vertices);
+            mesh->packed_vertices =
+                malloc(capacity * sizeof *mesh->packed_vertices);
+            if (!mesh->packed_vertices) goto memory_error;
+        }
+        else if (HEIGHT_VERTICES) {
+            free(mesh->radii);
+            mesh->radii = malloc(capacity * sizeof *mesh->radii);
+            if (!mesh->radii) goto memory_error;
+        }
+        else {
+            free(mesh->vertices);
+            free(mesh->normals);
+            mesh->vertices = malloc(capacity * sizeof *mesh->vertices);
+            mesh->normals  = malloc(capacity * sizeof *mesh->normals);
+            if (!mesh->vertices || !mesh->normals) goto memory_error;
+        }
+        planet->mesh_capacities[slot] = capacity;
+    }
+    return;
+
+memory_error:
+    fprintf(stderr, "ERROR: failed to allocate planet buffers\n");
+    exit(EXIT_FAILURE);
+}
+
+static uint64_t
+vertex_buffer_bytes(struct planet* planet)
+{
+    size_t per_vertex = sizeof(float);
+    if (!HEIGHT_VERTICES) per_vertex += sizeof(struct vec3) * 3;
+    for (uint32_t layer = 0; layer < NOISE_MAX_LAYERS; layer++) {
+        if (planet->octave_sums[layer]) per_vertex += sizeof(float);
+        if (planet->octave_gradient_sums[layer])
+            per_vertex += sizeof(struct vec3);
+    }
+    size_t mesh_vertex_size = sizeof(struct vec3) * 2;
+    if (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_PACKED)
+        mesh_vertex_size = sizeof(struct planet_packed_vertex);
+    if (HEIGHT_VERTICES) mesh_vertex_size = sizeof(float);
+
+    uint64_t bytes = (uint64_t)planet->vertex_capacity * per_vertex;
+    for (uint32_t slot = 0; slot < 3; slot++) {
+        bytes += (uint64_t)planet->mesh_capacities[slot] * mesh_vertex_size;
+    }
+    return bytes;
+}
+
+static void
+destroy_topology(struct planet_topology* topology)
+{
+    free(topology->indices);
+    vec3_soa_destroy(topology->directions);
+    free(topology->neighbours);
+    free(topology);
+}
 
-    for (uint32_t i = 0; i < 6; i++) {
-        SDL_WaitThread(threads[i], NULL);
+static bool
+topology_in_use(struct planet* planet, const struct planet_topology* topology)
+{
+    for (uint32_t slot = 0; slot < 3; slot++) {
+        if (slot != planet->back_mesh &&
+            planet->mesh_topologies[slot] == topology)
+            return true;
+    }
+    return false;
+}
+
+// evicts least recently used topologies until another incoming bytes fit in
+// the budget, or until only topologies in use are left
+static void
+evict_topologies(struct planet* planet, size_t incoming)
+{
+    while (planet->topology_bytes + incoming > planet->topology_budget) {
+        uint32_t victim = planet->topology_count;
+        for (uint32_t i = 0; i < planet->topology_count; i++) {
+            struct planet_topology* topology = planet->topologies[i];
+            if (topology_in_use(planet, topology)) continue;
+            if (victim == planet->topology_count ||
+                topology->last_used < planet->topologies[victim]->last_used)
+                victim = i;
+        }
+        if (victim == planet->topology_count) return;
+
+        struct planet_topology* topology = planet->topologies[victim];
+        if (planet->mesh_topologies[planet->back_mesh] == topology)
+            planet->mesh_topologies[planet->back_mesh] = NULL;
+        planet->topology_bytes -= topology->bytes;
+        planet->topologies[victim] =
+            planet->topologies[--planet->topology_count];
+        destroy_topology(topology);
     }
 }
 
+// the topology the next mesh will be indexed by, the cached one if these
+// subdivisions were used recently. Otherwise a new one is added to the cache
+// with its indices still to be built.
+static struct planet_topology*
+acquire_topology(struct planet* planet, uint32_t subdivisions)
+{
+    for (uint32_t i = 0; i < planet->topology_count; i++) {
+        struct planet_topology* topology = planet->topologies[i];
+        if (topology->subdivisions == subdivisions) {
+            topology->last_used = ++planet->topology_clock;
+            return topology;
+        }
+    }
+
+    const size_t vertex_count = stitched_vertex_count(subdivisions);
+    const size_t index_count  = stitched_index_count(subdivisions);
+    size_t bytes =
+        index_count * sizeof(uint32_t) + vertex_count * sizeof(struct vec3);
+    if (HEIGHT_VERTICES)
+        bytes += vertex_count * PLANET_MAX_NEIGHBOURS * sizeof(uint32_t);
+    evict_topologies(planet, bytes);
+
+    if (planet->topology_count == planet->topology_capacity) {
+        uint32_t capacity = (planet->topology_capacity)
+                                ? planet->topology_capacity * 2
+                                : 4;
+        struct planet_topology** topologies =
+            realloc(planet->topologies, capacity * sizeof *topologies);
+        if (topologies == NULL) goto memory_error;
+        planet->topologies        = topologies;
+        planet->topology_capacity = capacity;
+    }
+
+    struct planet_topology* topology = calloc(1, sizeof *topology);
+    if (topology == NULL) goto memory_error;
+    topology->subdivisions = subdivisions;
+    topology->last_used    = ++planet->topology_clock;
+    topology->bytes        = bytes;
+    topology->indices      = malloc(index_count * sizeof(uint32_t));
+    topology->directions   = vec3_soa_create(vertex_count);
+    if (topology->indices == NULL || topology->directions.x == NULL)
+        goto memory_error;
+    if (HEIGHT_VERTICES) {
+        topology->neighbours =
+            malloc(vertex_count * PLANET_MAX_NEIGHBOURS * sizeof(uint32_t));
+        if (topology->neighbours == NULL) goto memory_error;
+    }
+
+    planet->topologies[planet->topology_count++] = topology;
+    planet->topology_bytes += bytes;
+    return topology;
+
+memory_error:
+    fprintf(stderr, "ERROR: failed to allocate planet topology\n");
+    exit(EXIT_FAILURE);
+}
+
 static int
 planet_generation_main(struct planet* planet)
 {
-    while (!check_shutdown_signal(planet)) {
-        SDL_LockMutex(planet->mutex);
+    SDL_LockMutex(planet->mutex);
+    while (1) {
+        // sleep until a setter changes the configuration, generated_params is
+        // only ever written by this thread
+        while (!planet->shutdown_signal &&
+               planet->configured_normals == planet->generated_normals &&
+               memcmp(
+                   &planet->configured_params,
+                   &planet->generated_params,
+                   sizeof planet->configured_params
+               ) == 0) {
+            SDL_CondWait(planet->generator_wakeup, planet->mutex);
+        }
+        if (planet->shutdown_signal) break;
+
         struct generation_params configured = planet->configured_params;
+        int      epoch        = SDL_AtomicGet(&planet->configuration_epoch);
+        bool     preview      = false;
+        uint32_t worker_count = planet->configured_worker_count;
+        bool     octave_cache = planet->configured_octave_cache;
+        enum planet_normals normals = planet->configured_normals;
+        planet->tile_rows           = planet->configured_tile_rows;
+        planet->topology_budget     = planet->configured_topology_budget;
+        planet->shrink_buffers      = planet->configured_shrink_buffers;
         SDL_UnlockMutex(planet->mutex);
-        bool requires_regeneration =
-            (memcmp(
-                 &configured, &planet->generated_params, sizeof configured
-             ) != 0);
-
-        if (requires_regeneration) {
-            uint32_t vertex_count = (configured.subdivisions + 1) *
-                                    (configured.subdivisions + 1) * 6;
-            uint32_t index_count = (configured.subdivisions) *
-                                   (configured.subdivisions) * 2 * 3 * 6;
-            assert(vertex_count <= PLANET_MAX_VERTICES);
-            assert(index_count <= PLANET_MAX_INDICES);
-
-            if (configured.seed != planet->generated_params.seed) {
-                simplex_context_destroy(planet->simplex);
-                planet->simplex = simplex_context_create(configured.seed);
+
+        if (worker_count != planet->worker_count) {
+            thread_pool_destroy(planet->workers);
+            planet->workers      = thread_pool_create(worker_count);
+            planet->worker_count = worker_count;
+        }
+
+        // large builds publish a coarse preview of the new parameters first,
+        // the loop comes straight back around to refine it as the preview
+        // subdivisions won't match the configured ones. Rescaling cached
+        // heights or resuming cached octaves is cheap enough to skip straight
+        // to full resolution.
+        bool gradients =
+            !HEIGHT_VERTICES && normals == PLANET_NORMALS_ANALYTIC;
+        bool reuse_heights = planet->heights_valid &&
+                             heights_match(configured, planet->height_params) &&
+                             (planet->gradients_valid || !gradients);
+        bool reuse_octaves = octave_cache && planet->cached_layers > 0 &&
+                             octaves_match(configured, planet->octave_params);
+        if (configured.subdivisions >= PLANET_PREVIEW_MIN_SUBDIVISIONS &&
+            !reuse_heights && !reuse_octaves) {
+            struct generation_params coarse = configured;
+            coarse.subdivisions /= PLANET_PREVIEW_DIVISOR;
+            if (memcmp(&coarse, &planet->generated_params, sizeof coarse) !=
+                0) {
+                configured = coarse;
+                preview    = true;
             }
-            construct_subdivided_cube(
-                planet,
-                &configured,
-                planet->generated_params.subdivisions != configured.subdivisions
+        }
+
+        uint32_t vertex_count = stitched_vertex_count(configured.subdivisions);
+        uint32_t index_count  = stitched_index_count(configured.subdivisions);
+        assert(vertex_count <= PLANET_MAX_VERTICES);
+        assert(index_count <= PLANET_MAX_INDICES);
+
+        // tracked separately from generated_params since an abandoned build
+        // may have already switched seeds
+        if (configured.seed != planet->simplex_seed) {
+            simplex_context_destroy(planet->simplex);
+            planet->simplex      = simplex_context_create_precision(
+                configured.seed, PLANET_SIMPLEX_PRECISION
             );
+            planet->simplex_seed = configured.seed;
+        }
+        // the heights are overwritten as soon as noise is evaluated, so they
+        // can't be trusted again until a build completes
+        if (!reuse_heights) planet->heights_valid = false;
+        reserve_vertex_buffers(planet, vertex_count);
+        prepare_octave_cache(planet, &configured, octave_cache, gradients);
+        if (reuse_heights) planet->octave_cache = false;
+
+        // indices and directions stay incomplete until a build finishes them,
+        // an abandoned build leaves them to the next build with the same
+        // subdivisions
+        struct planet_topology* topology =
+            acquire_topology(planet, configured.subdivisions);
+        bool build_topology = topology->version == 0;
+
+        SDL_AtomicSet(&planet->noise_calls, 0);
+        SDL_AtomicSet(&planet->octave_samples, 0);
+        uint64_t build_start = SDL_GetPerformanceCounter();
+        bool     completed   = construct_subdivided_cube(
+            planet,
+            &configured,
+            epoch,
+            topology,
+            build_topology,
+            reuse_heights,
+            normals
+        );
+        uint64_t build_end = SDL_GetPerformanceCounter();
+
+        SDL_LockMutex(planet->mutex);
+
+        // newer parameters arrived mid build, start over with those instead
+        if (!completed) {
+            planet->stats.abandoned_builds++;
+            continue;
+        }
 
-            SDL_LockMutex(planet->mutex);
-
-            struct vec3* current_vertices = planet->vertices;
-            struct vec3* current_normals  = planet->normals;
-            uint32_t*    current_indices  = planet->indices;
-            planet->indices               = planet->generator_indices;
-            planet->normals               = planet->generator_normals;
-            planet->vertices              = planet->generator_vertices;
-            planet->generator_indices     = current_indices;
-            planet->generator_normals     = current_normals;
-            planet->generator_vertices    = current_vertices;
-            planet->vertex_count          = vertex_count;
-            planet->index_count           = index_count;
-            planet->generated_params      = configured;
-            planet->id++;
-
-            SDL_UnlockMutex(planet->mutex);
+        if (configured.subdivisions != planet->generated_params.subdivisions) {
+            if (build_topology)
+                planet->stats.topology_misses++;
+            else
+                planet->stats.topology_hits++;
         }
 
-        if (check_shutdown_signal(planet)) break;
-        SDL_Delay(1);
+        planet->generated_params  = configured;
+        planet->generated_normals = normals;
+        planet->height_params     = configured;
+        planet->heights_valid     = true;
+        if (!reuse_heights) planet->gradients_valid = gradients;
+        if (planet->octave_cache &&
+            configured.noise_layers > planet->cached_layers)
+            planet->cached_layers = configured.noise_layers;
+        planet->id++;
+        if (build_topology) topology->version = ++planet->topology_version;
+
+        struct planet_mesh* mesh = planet->meshes + planet->back_mesh;
+        mesh->iteration          = planet->id;
+        mesh->vertex_count       = vertex_count;
+        mesh->index_count        = index_count;
+        mesh->indices            = topology->indices;
+        mesh->directions         = topology->directions;
+        mesh->neighbours         = topology->neighbours;
+        mesh->topology_version   = topology->version;
+
+        planet->mesh_topologies[planet->back_mesh] = topology;
+
+        // hand the finished mesh over and take back whichever slot was
+        // waiting, if the reader never picked it up it was simply skipped.
+        // SDL_AtomicSet only orders as an acquire on some platforms, the
+        // barriers make the mesh written above visible before its slot and
+        // keep the reader's last reads of the slot handed back before our
+        // writes to it.
+        SDL_MemoryBarrierRelease();
+        int previous_ready = SDL_AtomicSet(
+            &planet->ready_mesh, (int)planet->back_mesh | READY_MESH_FRESH
+        );
+        SDL_MemoryBarrierAcquire();
+        planet->published_mesh = planet->back_mesh;
+        planet->back_mesh      = (uint32_t)previous_ready & READY_MESH_SLOT;
+
+        // the topology of the mesh handed back may no longer be in use, so
+        // this is the earliest the cache can get back within its budget
+        evict_topologies(planet, 0);
+
+        planet->stats.builds++;
+        if (preview) planet->stats.preview_builds++;
+        planet->stats.worker_count =
+            thread_pool_thread_count(planet->workers);
+        planet->stats.tile_rows      = planet->tile_rows;
+        planet->stats.last_build_ms  = elapsed_ms(build_start, build_end);
+        planet->stats.vertex_pass_ms = planet->vertex_pass_ms;
+        planet->stats.normal_pass_ms = planet->normal_pass_ms;
+        planet->stats.topology_bytes = planet->topology_bytes;
+        planet->stats.buffer_bytes   = vertex_buffer_bytes(planet);
+        planet->stats.vertex_count   = vertex_count;
+
+        // compared against evaluating every face's grid independently, which
+        // repeats the noise for each face an edge or corner vertex touches
+        uint64_t face_grid_vertices = (uint64_t)(configured.subdivisions + 1) *
+                                      (configured.subdivisions + 1) * 6;
+        planet->stats.noise_calls =
+            (uint64_t)SDL_AtomicGet(&planet->noise_calls);
+        planet->stats.noise_calls_saved =
+            face_grid_vertices - planet->stats.noise_calls;
+        planet->stats.octave_samples =
+            (uint64_t)SDL_AtomicGet(&planet->octave_samples);
     }
+    SDL_UnlockMutex(planet->mutex);
     return 0;
 }
 
@@ -421,31 +1646,37 @@ planet_create(uint32_t subdivisions, int seed)
     planet = calloc(1, sizeof *planet);
     if (planet == NULL) goto memory_error;
 
-    planet->vertices = calloc(PLANET_MAX_VERTICES, sizeof *planet->vertices);
-    planet->normals  = calloc(PLANET_MAX_VERTICES, sizeof *planet->normals);
-    planet->indices  = calloc(PLANET_MAX_INDICES, sizeof *planet->indices);
-    planet->generator_vertices =
-        calloc(PLANET_MAX_VERTICES, sizeof *planet->vertices);
-    planet->generator_normals =
-        calloc(PLANET_MAX_VERTICES, sizeof *planet->normals);
-    planet->generator_indices =
-        calloc(PLANET_MAX_INDICES, sizeof *planet->indices);
-
-    if (!planet->vertices || !planet->normals || !planet->indices ||
-        !planet->generator_vertices || !planet->generator_indices ||
-        !planet->generator_normals)
-        goto memory_error;
+    // the vertex buffers are allocated by the generator once it knows what
+    // size the first mesh needs
+    planet->front_mesh     = 0;
+    planet->published_mesh = 1;
+    planet->back_mesh      = 2;
+    SDL_AtomicSet(&planet->ready_mesh, 1);
 
     planet->configured_params.subdivisions     = subdivisions;
+    planet->configured_params.seed             = (int64_t)seed;
     planet->configured_params.noise_gain       = NOISE_INITIAL_GAIN;
     planet->configured_params.noise_frequency  = NOISE_INITIAL_FREQUENCY;
     planet->configured_params.noise_lacunarity = NOISE_INITIAL_LACUNARITY;
     planet->configured_params.noise_layers     = NOISE_INITIAL_LAYERS;
     planet->configured_params.noise_scale      = NOISE_INITIAL_SCALE;
+    planet->configured_tile_rows               = PLANET_DEFAULT_TILE_ROWS;
+    planet->configured_octave_cache            = PLANET_DEFAULT_OCTAVE_CACHE;
+    planet->configured_topology_budget         = PLANET_DEFAULT_TOPOLOGY_BUDGET;
+    planet->configured_shrink_buffers          = PLANET_DEFAULT_SHRINK_BUFFERS;
+    planet->configured_normals                 = PLANET_DEFAULT_NORMALS;
+    planet->generated_normals                  = PLANET_DEFAULT_NORMALS;
+
+    planet->simplex          = simplex_context_create_precision(
+        (int64_t)seed, PLANET_SIMPLEX_PRECISION
+    );
+    planet->simplex_seed     = (int64_t)seed;
+    planet->mutex            = SDL_CreateMutex();
+    planet->generator_wakeup = SDL_CreateCond();
+    if (!planet->mutex || !planet->generator_wakeup) goto memory_error;
 
-    planet->simplex = simplex_context_create((int64_t)seed);
-    planet->mutex   = SDL_CreateMutex();
-    if (!planet->mutex) goto memory_error;
+    // long lived so rebuilds don't pay for thread creation/teardown
+    planet->workers = thread_pool_create(planet->worker_count);
 
     planet->thread = SDL_CreateThread(
         (SDL_ThreadFunction)planet_generation_main,
@@ -464,16 +1695,28 @@ void
 planet_destroy(struct planet* planet)
 {
     if (planet == NULL) return;
-    simplex_context_destroy(planet->simplex);
     set_shutdown_signal(planet);
     SDL_WaitThread(planet->thread, NULL);
+    thread_pool_destroy(planet->workers);
+    simplex_context_destroy(planet->simplex);
+    SDL_DestroyCond(planet->generator_wakeup);
     SDL_DestroyMutex(planet->mutex);
-    free(planet->vertices);
-    free(planet->indices);
-    free(planet->normals);
-    free(planet->generator_vertices);
-    free(planet->generator_indices);
-    free(planet->generator_normals);
+    free(planet->tiles);
+    free(planet->heights);
+    free(planet->gradients);
+    vec3_soa_destroy(planet->positions);
+    vec3_soa_destroy(planet->normals);
+    release_octave_cache(planet);
+    for (uint32_t i = 0; i < 3; i++) {
+        free(planet->meshes[i].vertices);
+        free(planet->meshes[i].normals);
+        free(planet->meshes[i].packed_vertices);
+        free(planet->meshes[i].radii);
+    }
+    for (uint32_t i = 0; i < planet->topology_count; i++) {
+        destroy_topology(planet->topologies[i]);
+    }
+    free(planet->topologies);
     free(planet);
 }
 
@@ -495,6 +1738,7 @@ planet_set_subdivisions(struct planet* planet, uint32_t subdivisions)
     }
     SDL_LockMutex(planet->mutex);
     planet->configured_params.subdivisions = subdivisions;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
@@ -503,6 +1747,7 @@ planet_set_noise_layers(struct planet* planet, uint32_t layers)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.noise_layers = layers;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
@@ -511,6 +1756,7 @@ planet_set_noise_gain(struct planet* planet, float gain)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.noise_gain = gain;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
@@ -519,6 +1765,7 @@ planet_set_noise_frequency(struct planet* planet, float frequency)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.noise_frequency = frequency;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
@@ -527,6 +1774,7 @@ planet_set_noise_lacunarity(struct planet* planet, float lacunarity)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.noise_lacunarity = lacunarity;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
@@ -535,33 +1783,96 @@ planet_set_noise_scale(struct planet* planet, float scale)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.noise_scale = scale;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
+void
+planet_set_worker_count(struct planet* planet, uint32_t count)
+{
+    SDL_LockMutex(planet->mutex);
+    planet->configured_worker_count = count;
+    SDL_UnlockMutex(planet->mutex);
+}
+
+void
+planet_set_tile_rows(struct planet* planet, uint32_t rows)
+{
+    if (rows == 0) rows = 1;
+    SDL_LockMutex(planet->mutex);
+    planet->configured_tile_rows = rows;
+    SDL_UnlockMutex(planet->mutex);
+}
+
+void
+planet_set_octave_cache(struct planet* planet, bool enabled)
+{
+    SDL_LockMutex(planet->mutex);
+    planet->configured_octave_cache = enabled;
+    SDL_UnlockMutex(planet->mutex);
+}
+
+void
+planet_set_shrink_buffers(struct planet* planet, bool enabled)
+{
+    SDL_LockMutex(planet->mutex);
+    planet->configured_shrink_buffers = enabled;
+    SDL_UnlockMutex(planet->mutex);
+}
+
+void
+planet_set_topology_budget(struct planet* planet, size_t bytes)
+{
+    SDL_LockMutex(planet->mutex);
+    planet->configured_topology_budget = bytes;
+    SDL_UnlockMutex(planet->mutex);
+}
+
+struct planet_stats
+planet_get_stats(struct planet* planet)
+{
+    SDL_LockMutex(planet->mutex);
+    struct planet_stats stats = planet->stats;
+    SDL_UnlockMutex(planet->mutex);
+    return stats;
+}
+
 void
 planet_set_seed(struct planet* planet, int seed)
 {
     SDL_LockMutex(planet->mutex);
     planet->configured_params.seed = (int64_t)seed;
+    notify_configuration_changed(planet);
+    SDL_UnlockMutex(planet->mutex);
+}
+
+void
+planet_set_normals(struct planet* planet, enum planet_normals normals)
+{
+    SDL_LockMutex(planet->mutex);
+    planet->configured_normals = normals;
+    notify_configuration_changed(planet);
     SDL_UnlockMutex(planet->mutex);
 }
 
 struct planet_mesh
 planet_acquire_mesh(struct planet* planet)
 {
-    SDL_LockMutex(planet->mutex);
-    return (struct planet_mesh){
-        .iteration    = planet->id,
-        .index_count  = planet->index_count,
-        .vertex_count = planet->vertex_count,
-        .vertices     = planet->vertices,
-        .normals      = planet->normals,
-        .indices      = planet->indices,
-    };
+    // only swap when there is something new, otherwise we'd hand the
+    // generator back the mesh we're about to read
+    // see the publish in planet_generation_main for the barriers
+    if (SDL_AtomicGet(&planet->ready_mesh) & READY_MESH_FRESH) {
+        SDL_MemoryBarrierRelease();
+        int ready = SDL_AtomicSet(&planet->ready_mesh, (int)planet->front_mesh);
+        SDL_MemoryBarrierAcquire();
+        planet->front_mesh = (uint32_t)ready & READY_MESH_SLOT;
+    }
+    return planet->meshes[planet->front_mesh];
 }
 
 void
 planet_release_mesh(struct planet* planet)
 {
-    SDL_UnlockMutex(planet->mutex);
+    // meshes stay valid until the next acquire, nothing to do
+    (void)planet;
 }
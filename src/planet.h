@@ -1,6 +1,7 @@
 #ifndef PLANET_H
 #define PLANET_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <math.h>
@@ -11,6 +12,69 @@
 #define PLANET_MAX_SUBDIVISIONS 500
 #define PLANET_RADIUS 100.0f
 
+// rows of a cube face generated per thread pool task
+#define PLANET_DEFAULT_TILE_ROWS 8
+
+// keep running fbm sums for every layer so changing the layer count only
+// samples the layers that weren't there before. It costs 4 bytes per vertex for
+// each layer in use, and analytic normals add 12 bytes per vertex of gradient
+// sums for each layer they sample a gradient from, several times the mesh
+// itself, so callers opt in with planet_set_octave_cache.
+#define PLANET_DEFAULT_OCTAVE_CACHE false
+
+// the indices and unit sphere directions built for recently used subdivisions
+// are kept around so returning to them doesn't rebuild anything, least recently
+// used ones are dropped once the cache is over budget. Topologies still in use
+// by a mesh are kept regardless.
+#define PLANET_DEFAULT_TOPOLOGY_BUDGET ((size_t)128 << 20)
+
+// buffers sized by the vertex or index count start out fitting the first
+// mesh and grow geometrically as the subdivisions increase. With shrinking
+// enabled they are also reallocated to fit once they are more than
+// PLANET_SHRINK_FACTOR times larger than needed, otherwise they keep the
+// largest size they've had.
+#define PLANET_DEFAULT_SHRINK_BUFFERS false
+#define PLANET_SHRINK_FACTOR 4
+
+// how vertex normals are produced. Analytic normals come straight from the
+// gradient of the noise, skipping the passes over every triangle that the
+// triangle normals need, but with the octave cache they cost another 12 bytes
+// per vertex for each cached layer within PLANET_NORMAL_DETAIL.
+enum planet_normals {
+    PLANET_NORMALS_TRIANGLES,
+    PLANET_NORMALS_ANALYTIC,
+};
+#define PLANET_DEFAULT_NORMALS PLANET_NORMALS_ANALYTIC
+
+// analytic normals leave out octaves whose location scale is above
+// subdivisions / PLANET_NORMAL_DETAIL, the mesh is too coarse to show them
+#define PLANET_NORMAL_DETAIL 2.0f
+
+// vertices are floats anyway so the noise they are displaced by is sampled in
+// single precision, twice as many points fit in each simd register
+#define PLANET_SIMPLEX_PRECISION SIMPLEX_PRECISION_FLOAT
+
+// how meshes store their vertices. Float meshes hold a position and a normal
+// as 3 floats each, packed meshes hold a single planet_packed_vertex per
+// vertex at a third of the size which the renderer decodes in
+// shaders/planet_packed.vert. Height meshes only hold the radius of each
+// vertex, shaders/planet_heights.vert rebuilds positions and normals from the
+// directions and neighbours the renderer keeps for each topology, so the
+// generator skips normals entirely and edits that keep the subdivisions upload
+// 4 bytes per vertex. Build with
+// -DPLANET_VERTEX_FORMAT=PLANET_VERTEX_FORMAT_PACKED (or _HEIGHTS) to switch.
+#define PLANET_VERTEX_FORMAT_FLOAT 0
+#define PLANET_VERTEX_FORMAT_PACKED 1
+#define PLANET_VERTEX_FORMAT_HEIGHTS 2
+#ifndef PLANET_VERTEX_FORMAT
+#define PLANET_VERTEX_FORMAT PLANET_VERTEX_FORMAT_FLOAT
+#endif
+
+// builds at or above the minimum subdivisions first publish a preview mesh
+// with 1/PLANET_PREVIEW_DIVISOR of the subdivisions before refining
+#define PLANET_PREVIEW_DIVISOR 8
+#define PLANET_PREVIEW_MIN_SUBDIVISIONS 64
+
 #define NOISE_MIN_GAIN 0.1f
 #define NOISE_MIN_FREQUENCY 0.01f
 #define NOISE_MIN_LACUNARITY 1.5f
@@ -35,32 +99,111 @@
 #define PLANET_MAX_INDICES                                                     \
     (PLANET_MAX_SUBDIVISIONS * PLANET_MAX_SUBDIVISIONS * 2 * 3 * 6)
 
-// allow for repeat edge/corner vertices because stitching them together
-// seems beyond the scope of a simple demo
+// faces share the vertices along the cube's edges and corners, so the interior
+// of each face (n - 1)^2 * 6 + the edges (n - 1) * 12 + the 8 corners
 #define PLANET_MAX_VERTICES                                                    \
-    ((PLANET_MAX_SUBDIVISIONS + 1) * (PLANET_MAX_SUBDIVISIONS + 1) * 6)
+    (PLANET_MAX_SUBDIVISIONS * PLANET_MAX_SUBDIVISIONS * 6 + 2)
 
 typedef struct planet* Planet;
 
+// the most triangles around a vertex, every quad is split along the same
+// diagonal so no vertex has more than 6
+#define PLANET_MAX_NEIGHBOURS 6
+
+// the position is the decoded direction scaled by a radius interpolated
+// between the mesh's radius_min and radius_max
+struct planet_packed_vertex {
+    int16_t  direction[2];  // octahedral encoded, snorm
+    uint16_t radius;        // unorm
+    int8_t   normal[2];     // octahedral encoded, snorm
+};
+
+// indices only change with the subdivisions, meshes with the same
+// topology_version share the same indices so they only need uploading when it
+// changes. They must not be written to.
+//
+// Depending on PLANET_VERTEX_FORMAT either vertices and normals,
+// packed_vertices or radii are filled in, the others are NULL.
+//
+// The unit direction of every vertex and, for height meshes, the vertices
+// sharing a triangle with it are shared along with the indices. Each vertex
+// has PLANET_MAX_NEIGHBOURS neighbours in counter clockwise order seen from
+// outside the planet, vertices with fewer repeat the last one.
 struct planet_mesh {
-    uint64_t     iteration;
-    size_t       vertex_count;
-    size_t       index_count;
-    struct vec3* vertices;
-    struct vec3* normals;
-    uint32_t*    indices;
+    uint64_t                     iteration;
+    uint64_t                     topology_version;
+    size_t                       vertex_count;
+    size_t                       index_count;
+    struct vec3*                 vertices;
+    struct vec3*                 normals;
+    struct planet_packed_vertex* packed_vertices;
+    float*                       radii;
+    float                        radius_min;
+    float                        radius_max;
+    uint32_t*                    indices;
+    struct vec3_soa              directions;
+    uint32_t*                    neighbours;
 };
 
-Planet             planet_create(uint32_t subdivisions, int seed);
-void               planet_destroy(Planet);
+struct planet_stats {
+    uint64_t builds;
+    uint64_t abandoned_builds;
+    uint64_t preview_builds;
+    uint64_t vertex_count;  // of the last published mesh
+    uint32_t worker_count;
+    uint32_t tile_rows;
+    float    last_build_ms;
+
+    // wall clock time of each pass of the last published build. The vertex
+    // pass includes the indices built alongside the vertices and there is no
+    // normal pass with analytic normals.
+    float vertex_pass_ms;
+    float normal_pass_ms;
+
+    // terrain_noise evaluations made by the last published build, and how many
+    // were avoided by sharing seam vertices between faces or by rescaling the
+    // heights cached from the previous build
+    uint64_t noise_calls;
+    uint64_t noise_calls_saved;
+
+    // simplex samples taken by the last published build, layer count changes
+    // served by the octave cache only sample the added layers
+    uint64_t octave_samples;
+
+    // subdivision changes served from the topology cache and ones that had to
+    // build their indices and directions, and the bytes the cache holds
+    uint64_t topology_hits;
+    uint64_t topology_misses;
+    uint64_t topology_bytes;
+
+    // bytes held by the meshes and the generator's per vertex buffers
+    uint64_t buffer_bytes;
+};
+
+Planet planet_create(uint32_t subdivisions, int seed);
+void   planet_destroy(Planet);
+
+// never blocks on the generator, the returned mesh stays valid until the next
+// call to planet_acquire_mesh. Meshes should only be acquired from one thread.
 struct planet_mesh planet_acquire_mesh(Planet);
 void               planet_release_mesh(Planet);
-void               planet_set_subdivisions(Planet, uint32_t);
-void               planet_set_noise_layers(Planet, uint32_t);
-void               planet_set_noise_gain(Planet, float);
-void               planet_set_noise_frequency(Planet, float);
-void               planet_set_noise_lacunarity(Planet, float);
-void               planet_set_noise_scale(Planet, float);
-void               planet_set_seed(Planet, int);
+
+void planet_set_subdivisions(Planet, uint32_t);
+void planet_set_noise_layers(Planet, uint32_t);
+void planet_set_noise_gain(Planet, float);
+void planet_set_noise_frequency(Planet, float);
+void planet_set_noise_lacunarity(Planet, float);
+void planet_set_noise_scale(Planet, float);
+void planet_set_seed(Planet, int);
+void planet_set_normals(Planet, enum planet_normals);
+
+// generator threading, applies from the next rebuild onwards
+// a worker count of 0 uses one thread per logical cpu
+void                planet_set_worker_count(Planet, uint32_t);
+void                planet_set_tile_rows(Planet, uint32_t);
+void                planet_set_octave_cache(Planet, bool);
+void                planet_set_topology_budget(Planet, size_t bytes);
+void                planet_set_shrink_buffers(Planet, bool);
+struct planet_stats planet_get_stats(Planet);
 
 #endif  // PLANET_H
@@ -1,6 +1,8 @@
 #include "renderer.h"
 
+#include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
@@ -8,7 +10,7 @@
 
 #include "3d.h"
 #include "planet.h"
-#include "transfer_buffer.h"
+#include "staging_ring.h"
 #include "imgui_wrapper.h"
 
 #define CONCURRENT_FRAMES 2
@@ -17,11 +19,73 @@ struct ubo {
     struct mat4 model;
     struct mat4 view;
     struct mat4 proj;
+
+    // radius range of the packed vertices being drawn
+    float radius_min;
+    float radius_max;
+};
+
+// packed vertices go in the first buffer of a vertex version on their own,
+// float vertices put positions in the first and normals in the second. Height
+// vertices put radii in the first and the vertex shader reads them along with
+// the directions and neighbours of the topology version as storage buffers.
+#define FLOAT_VERTICES (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_FLOAT)
+#define PACKED_VERTICES (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_PACKED)
+#define HEIGHT_VERTICES (PLANET_VERTEX_FORMAT == PLANET_VERTEX_FORMAT_HEIGHTS)
+#define VERTEX_SIZE                                                            \
+    ((PACKED_VERTICES)   ? sizeof(struct planet_packed_vertex)                 \
+     : (HEIGHT_VERTICES) ? sizeof(float)                                       \
+                         : sizeof(struct vec3))
+#define VERTEX_BUFFER_USAGE                                                    \
+    ((HEIGHT_VERTICES) ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT                    \
+                       : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+#define NEIGHBOURS_SIZE (PLANET_MAX_NEIGHBOURS * sizeof(uint32_t))
+
+// radii, x, y and z directions and neighbours
+#define STORAGE_BUFFER_COUNT 5
+
+#if PACKED_VERTICES
+#define VERTEX_SHADER_PATH "build/planet_packed.vert.spv"
+#elif HEIGHT_VERTICES
+#define VERTEX_SHADER_PATH "build/planet_heights.vert.spv"
+#else
+#define VERTEX_SHADER_PATH "build/planet.vert.spv"
+#endif
+
+// every upload is staged through a single ring of this size, meshes that
+// don't fit in what's left of it are uploaded over several frames
+#define STAGING_RING_SIZE ((size_t)32 << 20)
+
+// a mesh uploaded once and drawn by every frame in flight that needs it.
+// Vertex versions are keyed by the mesh iteration and hold the vertex data,
+// topology versions are keyed by its topology_version and hold the indices
+// followed by the directions and neighbours of height vertices. Each frame in
+// flight sets its bit in frames while it draws a version, which is destroyed
+// once no frame has its bit set and it is neither the latest complete version
+// nor being uploaded. That is at most one version per frame in flight plus
+// the one being uploaded, so MESH_VERSIONS always leaves one free.
+#define MESH_VERSION_BUFFERS 5
+#define MESH_VERSIONS (CONCURRENT_FRAMES + 1)
+
+struct mesh_version {
+    uint64_t              version;
+    size_t                count;
+    uint32_t              frames;
+    struct vulkano_buffer buffers[MESH_VERSION_BUFFERS];
+
+    // radius range of packed vertex versions
+    float radius_min;
+    float radius_max;
 };
 
-#define TRANSFER_BUFFER_SIZE                                                   \
-    (PLANET_MAX_VERTICES * sizeof(struct vec3) * 2 + sizeof(struct ubo) +      \
-     sizeof(uint32_t) * PLANET_MAX_INDICES + 10000)
+// vertex data, indices and the 4 topology buffers of height vertices
+#define MESH_UPLOAD_COPIES (2 + MESH_VERSION_BUFFERS)
+
+struct mesh_copy {
+    struct vulkano_buffer dst;
+    const uint8_t*        data;
+    size_t                size;
+};
 
 struct demo_renderer {
     struct vulkano* vk;
@@ -33,17 +97,32 @@ struct demo_renderer {
     float       rotation_speed;
     struct ubo  ubo;
 
+    size_t                upload_budget;
+    struct renderer_stats stats;
+
+    size_t                per_frame_alignment;
     size_t                ubo_size_per_frame;
     struct vulkano_buffer uniform_buffer;
 
-    size_t                vertices_buffer_size_per_frame;
-    struct vulkano_buffer vertices_buffer;
-
-    size_t                indices_buffer_size_per_frame;
-    struct vulkano_buffer indices_buffer;
+    // the latest complete versions are drawn, NULL until the first mesh
+    struct mesh_version  vertex_versions[MESH_VERSIONS];
+    struct mesh_version  topology_versions[MESH_VERSIONS];
+    struct mesh_version* drawn_vertices;
+    struct mesh_version* drawn_topology;
 
-    size_t                normals_buffer_size_per_frame;
-    struct vulkano_buffer normals_buffer;
+    // versions still being uploaded. The planet isn't acquired from again
+    // until the upload completes, so the mesh data the copies read from stays
+    // valid until then.
+    struct {
+        bool                 active;
+        struct mesh_version* vertices;
+        struct mesh_version* topology;
+        uint32_t             copy_count;
+        uint32_t             copy;
+        size_t               offset;
+        uint32_t             frames;
+        struct mesh_copy     copies[MESH_UPLOAD_COPIES];
+    } upload;
 
     VkRenderPass          render_pass;
     VkShaderModule        vertex_shader;
@@ -53,15 +132,10 @@ struct demo_renderer {
     VkPipelineLayout      pipeline_layout;
     VkPipeline            pipeline;
 
-    VkDescriptorSet        descriptor_sets[CONCURRENT_FRAMES];
-    VkCommandPool          transfer_command_pool;
-    struct transfer_buffer transfer_buffers[CONCURRENT_FRAMES];
-
-    struct {
-        size_t   vertex_count;
-        size_t   index_count;
-        uint64_t iteration;
-    } buffered_planets[CONCURRENT_FRAMES];
+    VkDescriptorSet     descriptor_sets[CONCURRENT_FRAMES];
+    VkCommandPool       transfer_command_pool;
+    struct staging_ring staging_ring;
+    VkSemaphore         staging_semaphore;
 };
 
 void
@@ -117,6 +191,15 @@ struct vulkano_data read_file_content(const char* filepath);
 #define ALIGN(size, alignment)                                                 \
     ((((size) + (alignment)-1) / (alignment)) * (alignment))
 
+static void
+destroy_mesh_version(struct vulkano* vk, struct mesh_version* version)
+{
+    for (size_t i = 0; i < MESH_VERSION_BUFFERS; i++) {
+        vulkano_buffer_destroy(vk, version->buffers + i);
+    }
+    *version = (struct mesh_version){0};
+}
+
 struct demo_renderer*
 renderer_create(struct vulkano* vk)
 {
@@ -143,6 +226,7 @@ renderer_create(struct vulkano* vk)
     );
     renderer->rotation       = (struct vec3){0.0f, 0.0f, 0.0f};
     renderer->rotation_speed = 0.1f;
+    renderer->upload_budget  = RENDERER_DEFAULT_UPLOAD_BUDGET;
     renderer->ubo.model      = model_matrix(
         (struct vec3){0.0f, 0.0f, 0.0f},
         (struct vec3){1.0f, 1.0f, 1.0f},
@@ -212,62 +296,15 @@ renderer_create(struct vulkano* vk)
 
     // create buffers
     //
-    // adding a bit of padding to the buffers so when they are at capacity the
-    // transfer buffer's alignment wont cause a slight overshoot
-    static const size_t BUFFER_PADDING = 256;
-
-    const size_t per_frame_alignment =
+    renderer->per_frame_alignment =
         vk->gpu.properties.limits.minUniformBufferOffsetAlignment;
 
-    renderer->vertices_buffer_size_per_frame =
-        ALIGN(PLANET_MAX_VERTICES * sizeof(struct vec3), per_frame_alignment);
-    renderer->vertices_buffer = vulkano_buffer_create(
-        vk,
-        (struct VkBufferCreateInfo){
-            .size = BUFFER_PADDING + renderer->vertices_buffer_size_per_frame *
-                                         CONCURRENT_FRAMES,
-            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        },
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &error
-    );
-
-    renderer->normals_buffer_size_per_frame =
-        ALIGN(PLANET_MAX_VERTICES * sizeof(struct vec3), per_frame_alignment);
-    renderer->normals_buffer = vulkano_buffer_create(
-        vk,
-        (struct VkBufferCreateInfo){
-            .size = BUFFER_PADDING +
-                    renderer->normals_buffer_size_per_frame * CONCURRENT_FRAMES,
-            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        },
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &error
-    );
-
-    renderer->indices_buffer_size_per_frame =
-        ALIGN(PLANET_MAX_INDICES * sizeof(uint32_t), per_frame_alignment);
-    renderer->indices_buffer = vulkano_buffer_create(
-        vk,
-        (struct VkBufferCreateInfo){
-            .size = BUFFER_PADDING +
-                    renderer->indices_buffer_size_per_frame * CONCURRENT_FRAMES,
-            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                     VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        },
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &error
-    );
-
     renderer->ubo_size_per_frame =
-        ALIGN(sizeof(renderer->ubo), per_frame_alignment);
+        ALIGN(sizeof(renderer->ubo), renderer->per_frame_alignment);
     renderer->uniform_buffer = vulkano_buffer_create(
         vk,
         (struct VkBufferCreateInfo){
-            .size = BUFFER_PADDING +
-                    renderer->ubo_size_per_frame * CONCURRENT_FRAMES,
+            .size  = renderer->ubo_size_per_frame * CONCURRENT_FRAMES,
             .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         },
@@ -278,7 +315,7 @@ renderer_create(struct vulkano* vk)
     // create pipeline components and pipeline
     //
     struct vulkano_data vertex_shader_content =
-        read_file_content("build/planet.vert.spv");
+        read_file_content(VERTEX_SHADER_PATH);
     struct vulkano_data fragment_shader_content =
         read_file_content("build/planet.frag.spv");
 
@@ -289,19 +326,52 @@ renderer_create(struct vulkano* vk)
     free(vertex_shader_content.data);
     free(fragment_shader_content.data);
 
+    static const VkDescriptorSetLayoutBinding DESCRIPTOR_BINDINGS[] = {
+        {
+            .binding         = 0,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+#if HEIGHT_VERTICES
+        {
+            .binding         = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+        {
+            .binding         = 2,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+        {
+            .binding         = 3,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+        {
+            .binding         = 4,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+        {
+            .binding         = 5,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        },
+#endif
+    };
     renderer->descriptor_set_layout = vulkano_create_descriptor_set_layout(
         vk,
         (struct VkDescriptorSetLayoutCreateInfo){
-            .bindingCount = 1,
-            .pBindings =
-                (struct VkDescriptorSetLayoutBinding[]){
-                    {
-                        .binding         = 0,
-                        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                        .descriptorCount = 1,
-                        .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
-                    },
-                },
+            .bindingCount =
+                sizeof DESCRIPTOR_BINDINGS / sizeof *DESCRIPTOR_BINDINGS,
+            .pBindings = DESCRIPTOR_BINDINGS,
         },
         &error
     );
@@ -309,13 +379,18 @@ renderer_create(struct vulkano* vk)
         vk,
         (struct VkDescriptorPoolCreateInfo){
             .maxSets       = CONCURRENT_FRAMES,
-            .poolSizeCount = 1,
+            .poolSizeCount = (HEIGHT_VERTICES) ? 2 : 1,
             .pPoolSizes =
                 (struct VkDescriptorPoolSize[]){
                     {
                         .type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                         .descriptorCount = CONCURRENT_FRAMES,
                     },
+                    {
+                        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount =
+                            STORAGE_BUFFER_COUNT * CONCURRENT_FRAMES,
+                    },
                 },
         },
         &error
@@ -328,6 +403,76 @@ renderer_create(struct vulkano* vk)
         },
         &error
     );
+#if HEIGHT_VERTICES
+    // the vertex shader reads everything from storage buffers
+    static const VkVertexInputBindingDescription*   VERTEX_BINDINGS   = NULL;
+    static const VkVertexInputAttributeDescription* VERTEX_ATTRIBUTES = NULL;
+    const uint32_t                                  binding_count     = 0;
+    const uint32_t                                  attribute_count   = 0;
+#elif PACKED_VERTICES
+    static const VkVertexInputBindingDescription VERTEX_BINDINGS[] = {
+        {
+            .binding   = 0,
+            .stride    = sizeof(struct planet_packed_vertex),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        },
+    };
+    static const VkVertexInputAttributeDescription VERTEX_ATTRIBUTES[] = {
+        {
+            .binding  = 0,
+            .location = 0,
+            .format   = VK_FORMAT_R16G16_SNORM,
+            .offset   = offsetof(struct planet_packed_vertex, direction),
+        },
+        {
+            .binding  = 0,
+            .location = 1,
+            .format   = VK_FORMAT_R16_UNORM,
+            .offset   = offsetof(struct planet_packed_vertex, radius),
+        },
+        {
+            .binding  = 0,
+            .location = 2,
+            .format   = VK_FORMAT_R8G8_SNORM,
+            .offset   = offsetof(struct planet_packed_vertex, normal),
+        },
+    };
+    const uint32_t binding_count =
+        sizeof VERTEX_BINDINGS / sizeof *VERTEX_BINDINGS;
+    const uint32_t attribute_count =
+        sizeof VERTEX_ATTRIBUTES / sizeof *VERTEX_ATTRIBUTES;
+#else
+    static const VkVertexInputBindingDescription VERTEX_BINDINGS[] = {
+        {
+            .binding   = 0,
+            .stride    = sizeof(struct vec3),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        },
+        {
+            .binding   = 1,
+            .stride    = sizeof(struct vec3),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        },
+    };
+    static const VkVertexInputAttributeDescription VERTEX_ATTRIBUTES[] = {
+        {
+            .binding  = 0,
+            .location = 0,
+            .format   = VK_FORMAT_R32G32B32_SFLOAT,
+            .offset   = 0,
+        },
+        {
+            .binding  = 1,
+            .location = 1,
+            .format   = VK_FORMAT_R32G32B32_SFLOAT,
+            .offset   = 0,
+        },
+    };
+    const uint32_t binding_count =
+        sizeof VERTEX_BINDINGS / sizeof *VERTEX_BINDINGS;
+    const uint32_t attribute_count =
+        sizeof VERTEX_ATTRIBUTES / sizeof *VERTEX_ATTRIBUTES;
+#endif
     renderer->pipeline = vulkano_create_graphics_pipeline(
         vk,
         (struct vulkano_pipeline_config){
@@ -347,36 +492,10 @@ renderer_create(struct vulkano* vk)
                 },
             .vertex_input_state =
                 {
-                    .vertexBindingDescriptionCount = 2,
-                    .pVertexBindingDescriptions =
-                        (struct VkVertexInputBindingDescription[]){
-                            {
-                                .binding   = 0,
-                                .stride    = sizeof(struct vec3),
-                                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-                            },
-                            {
-                                .binding   = 1,
-                                .stride    = sizeof(struct vec3),
-                                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-                            },
-                        },
-                    .vertexAttributeDescriptionCount = 2,
-                    .pVertexAttributeDescriptions =
-                        (struct VkVertexInputAttributeDescription[]){
-                            {
-                                .binding  = 0,
-                                .location = 0,
-                                .format   = VK_FORMAT_R32G32B32_SFLOAT,
-                                .offset   = 0,
-                            },
-                            {
-                                .binding  = 1,
-                                .location = 1,
-                                .format   = VK_FORMAT_R32G32B32_SFLOAT,
-                                .offset   = 0,
-                            },
-                        },
+                    .vertexBindingDescriptionCount   = binding_count,
+                    .pVertexBindingDescriptions      = VERTEX_BINDINGS,
+                    .vertexAttributeDescriptionCount = attribute_count,
+                    .pVertexAttributeDescriptions    = VERTEX_ATTRIBUTES,
                 },
             .input_assembly_state =
                 {
@@ -484,9 +603,9 @@ renderer_create(struct vulkano* vk)
         ubo_info.offset += ubo_info.range;
     }
 
-    // create transfer buffers
+    // create staging ring
     //
-    VkCommandBuffer transfer_command_buffers[CONCURRENT_FRAMES];
+    VkCommandBuffer transfer_command_buffers[STAGING_RING_SUBMISSIONS];
     renderer->transfer_command_pool = vulkano_create_command_pool(
         vk,
         (VkCommandPoolCreateInfo){
@@ -500,16 +619,14 @@ renderer_create(struct vulkano* vk)
         (struct VkCommandBufferAllocateInfo){
             .commandPool        = renderer->transfer_command_pool,
             .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-            .commandBufferCount = CONCURRENT_FRAMES,
+            .commandBufferCount = STAGING_RING_SUBMISSIONS,
         },
         transfer_command_buffers,
         &error
     );
-    for (size_t i = 0; i < CONCURRENT_FRAMES; i++) {
-        renderer->transfer_buffers[i] = transfer_buffer_create(
-            vk, TRANSFER_BUFFER_SIZE, transfer_command_buffers[i], &error
-        );
-    }
+    renderer->staging_ring = staging_ring_create(
+        vk, STAGING_RING_SIZE, transfer_command_buffers, &error
+    );
     if (error) exit(EXIT_FAILURE);
 
     renderer->ticks = (uint64_t)SDL_GetTicks();
@@ -521,17 +638,16 @@ renderer_destroy(struct demo_renderer* renderer)
 {
     vkDeviceWaitIdle(renderer->vk->device);
 
-    for (size_t i = 0; i < CONCURRENT_FRAMES; i++) {
-        transfer_buffer_destroy(renderer->vk, &renderer->transfer_buffers[i]);
-    }
+    staging_ring_destroy(renderer->vk, &renderer->staging_ring);
     vkDestroyCommandPool(
         renderer->vk->device, renderer->transfer_command_pool, NULL
     );
 
     vulkano_buffer_destroy(renderer->vk, &renderer->uniform_buffer);
-    vulkano_buffer_destroy(renderer->vk, &renderer->indices_buffer);
-    vulkano_buffer_destroy(renderer->vk, &renderer->vertices_buffer);
-    vulkano_buffer_destroy(renderer->vk, &renderer->normals_buffer);
+    for (size_t i = 0; i < MESH_VERSIONS; i++) {
+        destroy_mesh_version(renderer->vk, renderer->vertex_versions + i);
+        destroy_mesh_version(renderer->vk, renderer->topology_versions + i);
+    }
     vkDestroyRenderPass(renderer->vk->device, renderer->render_pass, NULL);
     vkDestroyShaderModule(renderer->vk->device, renderer->vertex_shader, NULL);
     vkDestroyShaderModule(
@@ -549,6 +665,293 @@ renderer_destroy(struct demo_renderer* renderer)
     vkDestroyPipeline(renderer->vk->device, renderer->pipeline, NULL);
 }
 
+static float
+elapsed_ms(uint64_t start, uint64_t end)
+{
+    return (float)(end - start) * 1000.0f /
+           (float)SDL_GetPerformanceFrequency();
+}
+
+static struct mesh_version*
+find_mesh_version(struct mesh_version versions[MESH_VERSIONS], uint64_t version)
+{
+    for (size_t i = 0; i < MESH_VERSIONS; i++) {
+        if (versions[i].buffers[0].handle && versions[i].version == version)
+            return versions + i;
+    }
+    return NULL;
+}
+
+// creates the buffers of a new version in a free slot of versions, leaving
+// out buffers of size 0
+static struct mesh_version*
+create_mesh_version(
+    struct demo_renderer*    renderer,
+    struct mesh_version      versions[MESH_VERSIONS],
+    uint64_t                 version,
+    size_t                   count,
+    const size_t             sizes[MESH_VERSION_BUFFERS],
+    const VkBufferUsageFlags usages[MESH_VERSION_BUFFERS],
+    VulkanoError*            error
+)
+{
+    struct mesh_version* created = NULL;
+    for (size_t i = 0; created == NULL && i < MESH_VERSIONS; i++) {
+        if (!versions[i].buffers[0].handle) created = versions + i;
+    }
+    assert(created);
+
+    for (size_t i = 0; i < MESH_VERSION_BUFFERS; i++) {
+        if (sizes[i] == 0) continue;
+        created->buffers[i] = vulkano_buffer_create(
+            renderer->vk,
+            (struct VkBufferCreateInfo){
+                .size  = sizes[i],
+                .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usages[i],
+            },
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            error
+        );
+    }
+    created->version = version;
+    created->count   = count;
+    created->frames  = 0;
+    return created;
+}
+
+// drops frame_index from the versions it drew, its previous submission has
+// completed by now, and destroys the versions nothing needs any longer
+static void
+release_mesh_versions(
+    struct demo_renderer* renderer,
+    struct mesh_version   versions[MESH_VERSIONS],
+    size_t                frame_index,
+    struct mesh_version*  drawn,
+    struct mesh_version*  uploading
+)
+{
+    for (size_t i = 0; i < MESH_VERSIONS; i++) {
+        struct mesh_version* version = versions + i;
+        version->frames &= ~((uint32_t)1 << frame_index);
+        if (version->frames || version == drawn || version == uploading)
+            continue;
+        destroy_mesh_version(renderer->vk, version);
+    }
+}
+
+static void
+add_mesh_copy(
+    struct demo_renderer* renderer,
+    struct vulkano_buffer dst,
+    const void*           data,
+    size_t                size
+)
+{
+    assert(renderer->upload.copy_count < MESH_UPLOAD_COPIES);
+    renderer->upload.copies[renderer->upload.copy_count++] = (struct mesh_copy){
+        .dst  = dst,
+        .data = data,
+        .size = size,
+    };
+}
+
+// creates the versions of a mesh that haven't been uploaded yet and queues
+// the copies filling them in
+static void
+start_mesh_upload(
+    struct demo_renderer* renderer,
+    struct planet_mesh    mesh,
+    VulkanoError*         error
+)
+{
+    if (*error || mesh.vertex_count == 0) return;
+
+    struct mesh_version* vertices =
+        find_mesh_version(renderer->vertex_versions, mesh.iteration);
+    struct mesh_version* topology =
+        find_mesh_version(renderer->topology_versions, mesh.topology_version);
+    if (vertices && topology) {
+        renderer->drawn_vertices = vertices;
+        renderer->drawn_topology = topology;
+        return;
+    }
+    renderer->upload.copy_count = 0;
+    renderer->upload.copy       = 0;
+    renderer->upload.offset     = 0;
+    renderer->upload.frames     = 0;
+
+    // indices, directions and neighbours only change along with the
+    // subdivisions
+    if (topology == NULL) {
+        const size_t direction_size =
+            (HEIGHT_VERTICES) ? sizeof(float) * mesh.vertex_count : 0;
+        const size_t topology_sizes[MESH_VERSION_BUFFERS] = {
+            sizeof *mesh.indices * mesh.index_count,
+            direction_size,
+            direction_size,
+            direction_size,
+            (HEIGHT_VERTICES) ? NEIGHBOURS_SIZE * mesh.vertex_count : 0,
+        };
+        static const VkBufferUsageFlags
+            TOPOLOGY_USAGES[MESH_VERSION_BUFFERS] = {
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        };
+        topology = create_mesh_version(
+            renderer,
+            renderer->topology_versions,
+            mesh.topology_version,
+            mesh.index_count,
+            topology_sizes,
+            TOPOLOGY_USAGES,
+            error
+        );
+        const void* data[MESH_VERSION_BUFFERS] = {
+            mesh.indices,
+            mesh.directions.x,
+            mesh.directions.y,
+            mesh.directions.z,
+            mesh.neighbours,
+        };
+        for (size_t i = 0; i < MESH_VERSION_BUFFERS; i++) {
+            if (topology_sizes[i] == 0) continue;
+            add_mesh_copy(
+                renderer, topology->buffers[i], data[i], topology_sizes[i]
+            );
+        }
+    }
+
+    if (vertices == NULL) {
+        const size_t vertex_sizes[MESH_VERSION_BUFFERS] = {
+            VERTEX_SIZE * mesh.vertex_count,
+            (FLOAT_VERTICES) ? sizeof(struct vec3) * mesh.vertex_count : 0,
+        };
+        static const VkBufferUsageFlags VERTEX_USAGES[MESH_VERSION_BUFFERS] = {
+            VERTEX_BUFFER_USAGE,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        };
+        vertices = create_mesh_version(
+            renderer,
+            renderer->vertex_versions,
+            mesh.iteration,
+            mesh.vertex_count,
+            vertex_sizes,
+            VERTEX_USAGES,
+            error
+        );
+        vertices->radius_min = mesh.radius_min;
+        vertices->radius_max = mesh.radius_max;
+
+        const void* data = mesh.vertices;
+        if (PACKED_VERTICES) data = mesh.packed_vertices;
+        if (HEIGHT_VERTICES) data = mesh.radii;
+        add_mesh_copy(renderer, vertices->buffers[0], data, vertex_sizes[0]);
+        if (FLOAT_VERTICES) {
+            add_mesh_copy(
+                renderer, vertices->buffers[1], mesh.normals, vertex_sizes[1]
+            );
+        }
+    }
+
+    renderer->upload.active   = true;
+    renderer->upload.vertices = vertices;
+    renderer->upload.topology = topology;
+}
+
+// stages up to budget bytes of the upload in progress, the versions it fills
+// are drawn from the frame that stages its last bytes onwards. Frames drawing
+// versions staged by earlier frames are still ordered after their copies
+// since those were submitted to the same queue before the frame's own
+// staging, whose semaphore the frame waits on.
+static void
+continue_mesh_upload(
+    struct demo_renderer* renderer, size_t budget, VulkanoError* error
+)
+{
+    if (*error || !renderer->upload.active) return;
+
+    struct staging_ring* ring = &renderer->staging_ring;
+    renderer->upload.frames++;
+    while (renderer->upload.copy < renderer->upload.copy_count) {
+        const struct mesh_copy* copy =
+            renderer->upload.copies + renderer->upload.copy;
+
+        // whole atoms only, so the ring's padding stays within the budget
+        size_t size = copy->size - renderer->upload.offset;
+        if (size > budget) size = budget - budget % ring->atom;
+        if (size == 0) return;
+
+        size_t staged = staging_ring_copy(
+            renderer->vk,
+            ring,
+            copy->dst,
+            renderer->upload.offset,
+            copy->data + renderer->upload.offset,
+            size,
+            true,
+            error
+        );
+        const size_t padded = ALIGN(staged, ring->atom);
+        budget              = (budget > padded) ? budget - padded : 0;
+        renderer->upload.offset += staged;
+        if (staged < size || *error) return;
+
+        if (renderer->upload.offset == copy->size) {
+            renderer->upload.copy++;
+            renderer->upload.offset = 0;
+        }
+    }
+
+    renderer->upload.active  = false;
+    renderer->drawn_vertices = renderer->upload.vertices;
+    renderer->drawn_topology = renderer->upload.topology;
+    renderer->stats.uploads++;
+    renderer->stats.last_upload_frames = renderer->upload.frames;
+}
+
+// height vertices are read from storage buffers which change along with the
+// versions the frame draws
+static void
+write_storage_descriptors(
+    struct demo_renderer*      renderer,
+    size_t                     frame_index,
+    const struct mesh_version* vertices,
+    const struct mesh_version* topology
+)
+{
+    const struct vulkano_buffer buffers[STORAGE_BUFFER_COUNT] = {
+        vertices->buffers[0],
+        topology->buffers[1],
+        topology->buffers[2],
+        topology->buffers[3],
+        topology->buffers[4],
+    };
+
+    VkDescriptorBufferInfo infos[STORAGE_BUFFER_COUNT];
+    VkWriteDescriptorSet   writes[STORAGE_BUFFER_COUNT];
+    for (uint32_t i = 0; i < STORAGE_BUFFER_COUNT; i++) {
+        infos[i] = (VkDescriptorBufferInfo){
+            .buffer = buffers[i].handle,
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+        writes[i] = (VkWriteDescriptorSet){
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = renderer->descriptor_sets[frame_index],
+            .dstBinding      = 1 + i,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .pBufferInfo     = infos + i,
+        };
+    }
+    vkUpdateDescriptorSets(
+        renderer->vk->device, STORAGE_BUFFER_COUNT, writes, 0, NULL
+    );
+}
+
 VkSubmitInfo
 renderer_draw(
     struct demo_renderer* renderer,
@@ -576,61 +979,85 @@ renderer_draw(
         renderer->rotation
     );
 
-    struct transfer_buffer* transfer = renderer->transfer_buffers + frame_index;
-    transfer_buffer_copy(
+    const uint64_t staging_start = SDL_GetPerformanceCounter();
+
+    struct mesh_version* uploading_vertices = NULL;
+    struct mesh_version* uploading_topology = NULL;
+    if (renderer->upload.active) {
+        uploading_vertices = renderer->upload.vertices;
+        uploading_topology = renderer->upload.topology;
+    }
+    release_mesh_versions(
+        renderer,
+        renderer->vertex_versions,
+        frame_index,
+        renderer->drawn_vertices,
+        uploading_vertices
+    );
+    release_mesh_versions(
+        renderer,
+        renderer->topology_versions,
+        frame_index,
+        renderer->drawn_topology,
+        uploading_topology
+    );
+
+    // a new mesh is only acquired once the last one is fully staged, the
+    // acquired mesh stays valid until then
+    if (!renderer->upload.active) {
+        start_mesh_upload(renderer, planet_acquire_mesh(planet), &error);
+        planet_release_mesh(planet);
+    }
+
+    // the mesh gets the frame's budget or whatever the ubo leaves of the
+    // staging ring, whichever is less. The budget is kept to whole atoms so
+    // padding never overshoots it, and to at least one so uploads progress.
+    struct staging_ring* ring        = &renderer->staging_ring;
+    const uint64_t       staged_head = ring->head;
+    const size_t         ubo_staging = ALIGN(sizeof renderer->ubo, ring->atom);
+
+    size_t upload_budget = renderer->upload_budget;
+    upload_budget -= upload_budget % ring->atom;
+    if (upload_budget < ring->atom) upload_budget = ring->atom;
+    size_t budget = staging_ring_available(renderer->vk, ring, &error);
+    if (error) exit(EXIT_FAILURE);
+    budget = (budget > ubo_staging) ? budget - ubo_staging : 0;
+    if (budget > upload_budget) budget = upload_budget;
+    continue_mesh_upload(renderer, budget, &error);
+
+    struct mesh_version* vertices = renderer->drawn_vertices;
+    struct mesh_version* topology = renderer->drawn_topology;
+    if (vertices && topology) {
+        vertices->frames |= (uint32_t)1 << frame_index;
+        topology->frames |= (uint32_t)1 << frame_index;
+        renderer->ubo.radius_min = vertices->radius_min;
+        renderer->ubo.radius_max = vertices->radius_max;
+    }
+
+    staging_ring_copy(
         renderer->vk,
-        transfer,
+        ring,
         renderer->uniform_buffer,
         renderer->ubo_size_per_frame * frame_index,
         &renderer->ubo,
-        (sizeof renderer->ubo),
+        sizeof renderer->ubo,
+        false,
         &error
     );
 
-    struct planet_mesh mesh = planet_acquire_mesh(planet);
-
-    bool planet_requires_transfer =
-        renderer->buffered_planets[frame_index].iteration != mesh.iteration;
-
-    if (planet_requires_transfer) {
-        transfer_buffer_copy(
-            renderer->vk,
-            transfer,
-            renderer->vertices_buffer,
-            renderer->vertices_buffer_size_per_frame * frame_index,
-            mesh.vertices,
-            (sizeof *mesh.vertices) * mesh.vertex_count,
-            &error
-        );
-        transfer_buffer_copy(
-            renderer->vk,
-            transfer,
-            renderer->normals_buffer,
-            renderer->normals_buffer_size_per_frame * frame_index,
-            mesh.normals,
-            (sizeof *mesh.normals) * mesh.vertex_count,
-            &error
-        );
-        transfer_buffer_copy(
-            renderer->vk,
-            transfer,
-            renderer->indices_buffer,
-            renderer->indices_buffer_size_per_frame * frame_index,
-            mesh.indices,
-            (sizeof *mesh.indices) * mesh.index_count,
-            &error
-        );
-        renderer->buffered_planets[frame_index].vertex_count =
-            mesh.vertex_count;
-        renderer->buffered_planets[frame_index].index_count = mesh.index_count;
-        renderer->buffered_planets[frame_index].iteration   = mesh.iteration;
+    if (HEIGHT_VERTICES && vertices && topology) {
+        write_storage_descriptors(renderer, frame_index, vertices, topology);
     }
 
-    planet_release_mesh(planet);
-
-    transfer_buffer_flush_async(renderer->vk, transfer, &error);
+    renderer->staging_semaphore =
+        staging_ring_flush(renderer->vk, ring, &error);
     if (error) exit(EXIT_FAILURE);
 
+    renderer->stats.upload_bytes  = ring->head - staged_head;
+    renderer->stats.upload_active = renderer->upload.active;
+    renderer->stats.upload_stall_ms =
+        elapsed_ms(staging_start, SDL_GetPerformanceCounter());
+
     vkCmdBindDescriptorSets(
         cmd,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -643,25 +1070,6 @@ renderer_draw(
     );
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->pipeline);
-    vkCmdBindIndexBuffer(
-        cmd,
-        renderer->indices_buffer.handle,
-        renderer->indices_buffer_size_per_frame * frame_index,
-        VK_INDEX_TYPE_UINT32
-    );
-    vkCmdBindVertexBuffers(
-        cmd,
-        0,
-        2,
-        (VkBuffer[]){
-            renderer->vertices_buffer.handle,
-            renderer->normals_buffer.handle,
-        },
-        (VkDeviceSize[]){
-            renderer->vertices_buffer_size_per_frame * frame_index,
-            renderer->normals_buffer_size_per_frame * frame_index,
-        }
-    );
     VkViewport viewport = {
         .x        = 0.0f,
         .y        = 0.0f,
@@ -675,21 +1083,33 @@ renderer_draw(
     };
     vkCmdSetViewport(cmd, 0, 1, &viewport);
     vkCmdSetScissor(cmd, 0, 1, &scissor);
-    vkCmdDrawIndexed(
-        cmd,
-        (uint32_t)renderer->buffered_planets[frame_index].index_count,
-        1,
-        0,
-        0,
-        0
-    );
+
+    // there is nothing to draw until the first mesh is generated
+    if (vertices && topology) {
+        vkCmdBindIndexBuffer(
+            cmd, topology->buffers[0].handle, 0, VK_INDEX_TYPE_UINT32
+        );
+        if (!HEIGHT_VERTICES) {
+            vkCmdBindVertexBuffers(
+                cmd,
+                0,
+                (FLOAT_VERTICES) ? 2 : 1,
+                (VkBuffer[]){
+                    vertices->buffers[0].handle,
+                    vertices->buffers[1].handle,
+                },
+                (VkDeviceSize[]){0, 0}
+            );
+        }
+        vkCmdDrawIndexed(cmd, (uint32_t)topology->count, 1, 0, 0, 0);
+    }
 
     static const VkPipelineStageFlags STAGE_MASK =
         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
     return (VkSubmitInfo){
         .waitSemaphoreCount = 1,
         .pWaitDstStageMask  = &STAGE_MASK,
-        .pWaitSemaphores    = &transfer->semaphore,
+        .pWaitSemaphores    = &renderer->staging_semaphore,
     };
 }
 
@@ -699,6 +1119,18 @@ renderer_set_rotation_speed(struct demo_renderer* renderer, float speed)
     renderer->rotation_speed = speed;
 }
 
+void
+renderer_set_upload_budget(struct demo_renderer* renderer, size_t bytes)
+{
+    renderer->upload_budget = bytes;
+}
+
+struct renderer_stats
+renderer_get_stats(struct demo_renderer* renderer)
+{
+    return renderer->stats;
+}
+
 struct vulkano_data
 read_file_content(const char* filepath)
 {
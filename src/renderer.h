@@ -4,14 +4,41 @@
 #include "vulkano.h"
 #include "planet.h"
 
+// bytes of mesh data staged per frame at most, a large mesh is streamed over
+// as many frames as it takes rather than copied in the frame it's published
+// and only drawn once complete
+#define RENDERER_DEFAULT_UPLOAD_BUDGET ((size_t)4 << 20)
+
 typedef struct demo_renderer* Renderer;
 
+struct renderer_stats {
+    // bytes staged by the last frame, mesh data and the ubo
+    uint64_t upload_bytes;
+
+    // time the last frame spent on uploads, creating the buffers of new
+    // versions, staging and any wait for room in the staging ring or for one
+    // of its command buffers
+    float upload_stall_ms;
+
+    // meshes fully uploaded, how many frames the last one was streamed over
+    // and whether another one is still streaming
+    uint64_t uploads;
+    uint32_t last_upload_frames;
+    bool     upload_active;
+};
+
 Renderer     renderer_create(struct vulkano* vk);
 void         renderer_destroy(Renderer);
 void         renderer_set_camera_position(Renderer, float x, float y, float z);
 void         renderer_set_camera_direction(Renderer, float x, float y, float z);
 void         renderer_set_camera_target(Renderer, float x, float y, float z);
 void         renderer_set_rotation_speed(Renderer, float);
+
+// the budget is rounded down to whole non coherent atoms of the device, and
+// up to one atom if that leaves nothing
+void                  renderer_set_upload_budget(Renderer, size_t bytes);
+struct renderer_stats renderer_get_stats(Renderer);
+
 VkSubmitInfo renderer_draw(
     Renderer,
     VkCommandBuffer cmd,
@@ -0,0 +1,304 @@
+#include "staging_ring.h"
+
+#include <string.h>
+
+#define ALIGN(size, alignment)                                                 \
+    ((((size) + (alignment)-1) / (alignment)) * (alignment))
+
+void
+staging_ring_destroy(struct vulkano* vk, struct staging_ring* ring)
+{
+    if (ring->buffer.handle == VK_NULL_HANDLE) return;
+    for (size_t i = 0; i < STAGING_RING_SUBMISSIONS; i++) {
+        vkDestroyFence(vk->device, ring->submissions[i].fence, NULL);
+        vkDestroySemaphore(vk->device, ring->submissions[i].semaphore, NULL);
+    }
+    vkUnmapMemory(vk->device, ring->buffer.memory);
+    vulkano_buffer_destroy(vk, &ring->buffer);
+    *ring = (struct staging_ring){0};
+}
+
+struct staging_ring
+staging_ring_create(
+    struct vulkano* vk,
+    size_t          capacity,
+    VkCommandBuffer cmds[STAGING_RING_SUBMISSIONS],
+    VulkanoError*   error
+)
+{
+    if (*error) return (struct staging_ring){0};
+
+    const size_t atom = vk->gpu.properties.limits.nonCoherentAtomSize;
+    capacity          = ALIGN(capacity, atom);
+
+    struct staging_ring ring = {
+        .capacity = capacity,
+        .atom     = atom,
+        .buffer   = vulkano_buffer_create(
+            vk,
+            (struct VkBufferCreateInfo){
+                  .size  = capacity,
+                  .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            },
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            error
+        ),
+    };
+    for (size_t i = 0; i < STAGING_RING_SUBMISSIONS; i++) {
+        ring.submissions[i] = (struct staging_submission){
+            .cmd   = cmds[i],
+            .fence = vulkano_create_fence(vk, (VkFenceCreateInfo){0}, error),
+            .semaphore = vulkano_create_semaphore(
+                vk, (VkSemaphoreCreateInfo){0}, error
+            ),
+        };
+    }
+    if (*error) {
+        staging_ring_destroy(vk, &ring);
+        return ring;
+    }
+
+    VULKANO_CHECK(
+        vkMapMemory(
+            vk->device,
+            ring.buffer.memory,
+            0,
+            capacity,
+            0,
+            (void**)&ring.mapped_memory
+        ),
+        error
+    );
+    if (*error) {
+        staging_ring_destroy(vk, &ring);
+        return ring;
+    }
+
+    return ring;
+}
+
+// submissions retire in the order they were flushed, the oldest one is the
+// next to be recorded into
+static bool
+retire_oldest_submission(
+    struct vulkano*      vk,
+    struct staging_ring* ring,
+    bool                 wait,
+    VulkanoError*        error
+)
+{
+    if (*error) return false;
+
+    size_t oldest = ring->current;
+    if (ring->recording) oldest = (oldest + 1) % STAGING_RING_SUBMISSIONS;
+    for (size_t i = 0; i < STAGING_RING_SUBMISSIONS; i++) {
+        if (ring->submissions[oldest].pending) break;
+        oldest = (oldest + 1) % STAGING_RING_SUBMISSIONS;
+    }
+
+    struct staging_submission* submission = ring->submissions + oldest;
+    if (!submission->pending) return false;
+
+    VkResult status = vkGetFenceStatus(vk->device, submission->fence);
+    if (status == VK_NOT_READY && !wait) return false;
+    if (status == VK_NOT_READY) {
+        VULKANO_CHECK(
+            vkWaitForFences(
+                vk->device, 1, &submission->fence, VK_TRUE, VULKANO_TIMEOUT
+            ),
+            error
+        );
+    }
+    else {
+        VULKANO_CHECK(status, error);
+    }
+    VULKANO_CHECK(vkResetFences(vk->device, 1, &submission->fence), error);
+    if (*error) return false;
+
+    submission->pending = false;
+    ring->tail          = submission->end;
+    return true;
+}
+
+size_t
+staging_ring_available(
+    struct vulkano* vk, struct staging_ring* ring, VulkanoError* error
+)
+{
+    if (*error) return 0;
+
+    while (retire_oldest_submission(vk, ring, false, error)) continue;
+    if (*error) return 0;
+    return ring->capacity - (size_t)(ring->head - ring->tail);
+}
+
+static void
+begin_submission(
+    struct vulkano* vk, struct staging_ring* ring, VulkanoError* error
+)
+{
+    if (*error || ring->recording) return;
+
+    // the command buffer is free again once the submission that last used
+    // it has completed
+    while (ring->submissions[ring->current].pending) {
+        if (!retire_oldest_submission(vk, ring, true, error)) return;
+    }
+
+    VULKANO_CHECK(
+        vkBeginCommandBuffer(
+            ring->submissions[ring->current].cmd,
+            (struct VkCommandBufferBeginInfo[]){
+                {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                },
+            }
+        ),
+        error
+    );
+    if (*error) return;
+
+    ring->recording       = true;
+    ring->submission_head = ring->head;
+}
+
+size_t
+staging_ring_copy(
+    struct vulkano*       vk,
+    struct staging_ring*  ring,
+    struct vulkano_buffer dst,
+    size_t                dst_offset,
+    const void*           data,
+    size_t                size,
+    bool                  partial,
+    VulkanoError*         error
+)
+{
+    if (*error || size == 0) return 0;
+
+    if (!partial && ALIGN(size, ring->atom) > ring->capacity) {
+        *error = VULKANO_ERROR_CODE_OUT_OF_MEMORY;
+        fprintf(stderr, "ERROR: copy exceeds staging ring capacity\n");
+        return 0;
+    }
+
+    begin_submission(vk, ring, error);
+    if (*error) return 0;
+
+    size_t available = staging_ring_available(vk, ring, error);
+    if (*error) return 0;
+    while (!partial && available < ALIGN(size, ring->atom)) {
+        if (!retire_oldest_submission(vk, ring, true, error)) {
+            if (*error) return 0;
+
+            // whatever is left is held by the submission being recorded
+            *error = VULKANO_ERROR_CODE_OUT_OF_MEMORY;
+            fprintf(stderr, "ERROR: staging ring is full\n");
+            return 0;
+        }
+        available = ring->capacity - (size_t)(ring->head - ring->tail);
+    }
+    if (size > available) size = available;
+    if (size == 0) return 0;
+
+    // copies crossing the end of the buffer are split in two
+    const size_t offset = (size_t)(ring->head % ring->capacity);
+    size_t       first  = size;
+    if (offset + first > ring->capacity) first = ring->capacity - offset;
+
+    VkCommandBuffer cmd = ring->submissions[ring->current].cmd;
+    memcpy(ring->mapped_memory + offset, data, first);
+    vkCmdCopyBuffer(
+        cmd,
+        ring->buffer.handle,
+        dst.handle,
+        1,
+        &(VkBufferCopy){
+            .srcOffset = offset,
+            .dstOffset = dst_offset,
+            .size      = first,
+        }
+    );
+    if (first < size) {
+        const uint8_t* rest = (const uint8_t*)data + first;
+        memcpy(ring->mapped_memory, rest, size - first);
+        vkCmdCopyBuffer(
+            cmd,
+            ring->buffer.handle,
+            dst.handle,
+            1,
+            &(VkBufferCopy){
+                .srcOffset = 0,
+                .dstOffset = dst_offset + first,
+                .size      = size - first,
+            }
+        );
+    }
+
+    ring->head += ALIGN(size, ring->atom);
+    return size;
+}
+
+VkSemaphore
+staging_ring_flush(
+    struct vulkano* vk, struct staging_ring* ring, VulkanoError* error
+)
+{
+    if (*error || !ring->recording) return VK_NULL_HANDLE;
+
+    struct staging_submission* submission = ring->submissions + ring->current;
+
+    // the staged bytes may wrap around the end of the buffer
+    const size_t offset = (size_t)(ring->submission_head % ring->capacity);
+    const size_t size   = (size_t)(ring->head - ring->submission_head);
+    size_t       first  = size;
+    if (offset + first > ring->capacity) first = ring->capacity - offset;
+    VkMappedMemoryRange ranges[2] = {
+        {
+            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .memory = ring->buffer.memory,
+            .offset = offset,
+            .size   = first,
+        },
+        {
+            .sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            .memory = ring->buffer.memory,
+            .offset = 0,
+            .size   = size - first,
+        },
+    };
+    if (size) {
+        VULKANO_CHECK(
+            vkFlushMappedMemoryRanges(
+                vk->device, (first < size) ? 2 : 1, ranges
+            ),
+            error
+        );
+    }
+    VULKANO_CHECK(vkEndCommandBuffer(submission->cmd), error);
+    if (*error) return VK_NULL_HANDLE;
+
+    VULKANO_CHECK(
+        vkQueueSubmit(
+            vk->gpu.graphics_queue,
+            1,
+            (const VkSubmitInfo[]){{
+                .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount   = 1,
+                .pCommandBuffers      = &submission->cmd,
+                .signalSemaphoreCount = 1,
+                .pSignalSemaphores    = &submission->semaphore,
+            }},
+            submission->fence
+        ),
+        error
+    );
+    if (*error) return VK_NULL_HANDLE;
+
+    submission->end     = ring->head;
+    submission->pending = true;
+    ring->recording     = false;
+    ring->current       = (ring->current + 1) % STAGING_RING_SUBMISSIONS;
+    return submission->semaphore;
+}
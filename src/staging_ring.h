@@ -0,0 +1,74 @@
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include "vulkano.h"
+#include <vulkan/vulkan.h>
+
+// flushes that can be in flight at once, each records into its own command
+// buffer. Starting one more than this waits for the oldest to complete.
+#define STAGING_RING_SUBMISSIONS 4
+
+struct staging_submission {
+    VkCommandBuffer cmd;
+    VkFence         fence;
+    VkSemaphore     semaphore;
+    uint64_t        end;  // head once the submission was flushed
+    bool            pending;
+};
+
+// a single persistently mapped staging buffer used as a ring. Copies are
+// staged at the head and recorded straight into the command buffer of the
+// current submission, their bytes are retired from the tail once the fence of
+// the submission that flushed them has signaled. The memory held is bounded
+// by the bytes in flight rather than by the largest upload, uploads that
+// don't fit are staged in parts by later flushes.
+//
+// head and tail count every byte staged and retired, the offset into the
+// buffer is them modulo the capacity. Both are kept to multiples of the non
+// coherent atom size so flushed ranges are always aligned.
+struct staging_ring {
+    struct vulkano_buffer     buffer;
+    size_t                    capacity;
+    size_t                    atom;
+    uint8_t*                  mapped_memory;
+    uint64_t                  head;
+    uint64_t                  tail;
+    uint64_t                  submission_head;
+    size_t                    current;
+    bool                      recording;
+    struct staging_submission submissions[STAGING_RING_SUBMISSIONS];
+};
+
+struct staging_ring staging_ring_create(
+    struct vulkano*,
+    size_t capacity,
+    VkCommandBuffer cmds[STAGING_RING_SUBMISSIONS],
+    VulkanoError*
+);
+void staging_ring_destroy(struct vulkano*, struct staging_ring*);
+
+// bytes that can be staged without waiting on the gpu
+size_t
+staging_ring_available(struct vulkano*, struct staging_ring*, VulkanoError*);
+
+// stages size bytes of data to be copied to dst at dst_offset by the next
+// flush. With partial set as much as is available is staged and the count
+// returned, the caller stages the rest later. Otherwise it waits for enough
+// submissions to retire and stages everything, size must fit in the ring.
+size_t staging_ring_copy(
+    struct vulkano*,
+    struct staging_ring*,
+    struct vulkano_buffer dst,
+    size_t                dst_offset,
+    const void*           data,
+    size_t                size,
+    bool                  partial,
+    VulkanoError*
+);
+
+// submits everything staged since the last flush, returns the semaphore
+// signaled once the copies complete or VK_NULL_HANDLE if nothing was staged
+VkSemaphore
+staging_ring_flush(struct vulkano*, struct staging_ring*, VulkanoError*);
+
+#endif  // STAGING_RING_H
@@ -0,0 +1,283 @@
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+struct thread_pool_entry {
+    ThreadPoolTask task;
+    void*          arg;
+};
+
+// entries[head, tail) are pending, the owning thread takes from the tail
+// (most recently pushed, likely still in cache) and thieves take from the head
+struct thread_pool_deque {
+    SDL_mutex*                mutex;
+    struct thread_pool_entry* entries;
+    size_t                    capacity;
+    size_t                    head;
+    size_t                    tail;
+};
+
+struct thread_pool {
+    SDL_mutex*   mutex;
+    SDL_cond*    work_available;
+    SDL_cond*    work_complete;
+    SDL_Thread** threads;
+    uint32_t     thread_count;
+    bool         shutdown;
+
+    // one deque per worker plus a final one owned by the thread calling
+    // thread_pool_wait
+    struct thread_pool_deque* deques;
+    uint32_t                  deque_count;
+    uint32_t                  next_deque;
+
+    SDL_atomic_t queued;       // sitting in a deque
+    SDL_atomic_t outstanding;  // queued + currently executing
+};
+
+struct thread_pool_worker {
+    struct thread_pool* pool;
+    uint32_t            index;
+};
+
+static void
+deque_push(struct thread_pool_deque* deque, struct thread_pool_entry entry)
+{
+    SDL_LockMutex(deque->mutex);
+    if (deque->tail == deque->capacity) {
+        size_t pending = deque->tail - deque->head;
+        if (pending * 2 <= deque->capacity && deque->capacity > 0) {
+            // plenty of room at the front, compact in place
+            memmove(
+                deque->entries,
+                deque->entries + deque->head,
+                pending * sizeof *deque->entries
+            );
+        }
+        else {
+            size_t new_capacity = (deque->capacity) ? deque->capacity * 2 : 64;
+            struct thread_pool_entry* entries =
+                malloc(new_capacity * sizeof *entries);
+            if (entries == NULL) {
+                fprintf(stderr, "ERROR: failed to grow thread pool deque\n");
+                exit(EXIT_FAILURE);
+            }
+            if (pending)
+                memcpy(
+                    entries,
+                    deque->entries + deque->head,
+                    pending * sizeof *entries
+                );
+            free(deque->entries);
+            deque->entries  = entries;
+            deque->capacity = new_capacity;
+        }
+        deque->head = 0;
+        deque->tail = pending;
+    }
+    deque->entries[deque->tail++] = entry;
+    SDL_UnlockMutex(deque->mutex);
+}
+
+static bool
+deque_pop(struct thread_pool_deque* deque, struct thread_pool_entry* out)
+{
+    bool found = false;
+    SDL_LockMutex(deque->mutex);
+    if (deque->tail > deque->head) {
+        *out  = deque->entries[--deque->tail];
+        found = true;
+    }
+    SDL_UnlockMutex(deque->mutex);
+    return found;
+}
+
+static bool
+deque_steal(struct thread_pool_deque* deque, struct thread_pool_entry* out)
+{
+    bool found = false;
+    SDL_LockMutex(deque->mutex);
+    if (deque->tail > deque->head) {
+        *out  = deque->entries[deque->head++];
+        found = true;
+    }
+    SDL_UnlockMutex(deque->mutex);
+    return found;
+}
+
+static bool
+take_task(
+    struct thread_pool* pool, uint32_t own_deque, struct thread_pool_entry* out
+)
+{
+    if (SDL_AtomicGet(&pool->queued) == 0) return false;
+
+    bool found = deque_pop(pool->deques + own_deque, out);
+    for (uint32_t i = 1; !found && i < pool->deque_count; i++) {
+        uint32_t victim = (own_deque + i) % pool->deque_count;
+        found           = deque_steal(pool->deques + victim, out);
+    }
+    if (found) SDL_AtomicAdd(&pool->queued, -1);
+    return found;
+}
+
+static void
+run_task(struct thread_pool* pool, struct thread_pool_entry entry)
+{
+    entry.task(entry.arg);
+    if (SDL_AtomicAdd(&pool->outstanding, -1) == 1) {
+        SDL_LockMutex(pool->mutex);
+        SDL_CondBroadcast(pool->work_complete);
+        SDL_UnlockMutex(pool->mutex);
+    }
+}
+
+static int
+thread_pool_worker_main(struct thread_pool_worker* worker)
+{
+    struct thread_pool* pool  = worker->pool;
+    uint32_t            index = worker->index;
+    free(worker);
+
+    while (1) {
+        struct thread_pool_entry entry;
+        if (take_task(pool, index, &entry)) {
+            run_task(pool, entry);
+            continue;
+        }
+
+        SDL_LockMutex(pool->mutex);
+        while (SDL_AtomicGet(&pool->queued) == 0 && !pool->shutdown) {
+            SDL_CondWait(pool->work_available, pool->mutex);
+        }
+        bool shutdown = pool->shutdown;
+        SDL_UnlockMutex(pool->mutex);
+        if (shutdown) break;
+    }
+    return 0;
+}
+
+struct thread_pool*
+thread_pool_create(uint32_t thread_count)
+{
+    if (thread_count == 0) {
+        int cpu_count = SDL_GetCPUCount();
+        thread_count  = (cpu_count > 0) ? (uint32_t)cpu_count : 1;
+    }
+
+    struct thread_pool* pool;
+    pool = calloc(1, sizeof *pool);
+    if (pool == NULL) goto memory_error;
+
+    // the thread calling thread_pool_wait makes up the difference
+    pool->thread_count   = thread_count - 1;
+    pool->deque_count    = thread_count;
+    pool->threads        = calloc(thread_count, sizeof *pool->threads);
+    pool->deques         = calloc(pool->deque_count, sizeof *pool->deques);
+    pool->mutex          = SDL_CreateMutex();
+    pool->work_available = SDL_CreateCond();
+    pool->work_complete  = SDL_CreateCond();
+    if (!pool->threads || !pool->deques || !pool->mutex ||
+        !pool->work_available || !pool->work_complete)
+        goto memory_error;
+
+    for (uint32_t i = 0; i < pool->deque_count; i++) {
+        pool->deques[i].mutex = SDL_CreateMutex();
+        if (!pool->deques[i].mutex) goto memory_error;
+    }
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        struct thread_pool_worker* worker = malloc(sizeof *worker);
+        if (worker == NULL) goto memory_error;
+        *worker = (struct thread_pool_worker){.pool = pool, .index = i};
+
+        pool->threads[i] = SDL_CreateThread(
+            (SDL_ThreadFunction)thread_pool_worker_main,
+            "thread pool worker",
+            worker
+        );
+        if (!pool->threads[i]) {
+            fprintf(stderr, "ERROR: failed to create thread pool worker\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return pool;
+
+memory_error:
+    fprintf(stderr, "ERROR: failed to allocate thread pool\n");
+    exit(EXIT_FAILURE);
+}
+
+void
+thread_pool_destroy(struct thread_pool* pool)
+{
+    if (pool == NULL) return;
+
+    thread_pool_wait(pool);
+
+    SDL_LockMutex(pool->mutex);
+    pool->shutdown = true;
+    SDL_CondBroadcast(pool->work_available);
+    SDL_UnlockMutex(pool->mutex);
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+    for (uint32_t i = 0; i < pool->deque_count; i++) {
+        SDL_DestroyMutex(pool->deques[i].mutex);
+        free(pool->deques[i].entries);
+    }
+
+    SDL_DestroyCond(pool->work_available);
+    SDL_DestroyCond(pool->work_complete);
+    SDL_DestroyMutex(pool->mutex);
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
+
+uint32_t
+thread_pool_thread_count(struct thread_pool* pool)
+{
+    return pool->deque_count;
+}
+
+void
+thread_pool_submit(struct thread_pool* pool, ThreadPoolTask task, void* arg)
+{
+    // spread submissions round robin, idle workers will steal the rest
+    uint32_t deque   = pool->next_deque;
+    pool->next_deque = (pool->next_deque + 1) % pool->deque_count;
+
+    SDL_AtomicAdd(&pool->outstanding, 1);
+    SDL_AtomicAdd(&pool->queued, 1);
+    deque_push(pool->deques + deque, (struct thread_pool_entry){task, arg});
+
+    SDL_LockMutex(pool->mutex);
+    SDL_CondSignal(pool->work_available);
+    SDL_UnlockMutex(pool->mutex);
+}
+
+void
+thread_pool_wait(struct thread_pool* pool)
+{
+    // help out rather than sleep while there is still queued work
+    const uint32_t own_deque = pool->deque_count - 1;
+
+    struct thread_pool_entry entry;
+    while (take_task(pool, own_deque, &entry)) {
+        run_task(pool, entry);
+    }
+
+    SDL_LockMutex(pool->mutex);
+    while (SDL_AtomicGet(&pool->outstanding) > 0) {
+        SDL_CondWait(pool->work_complete, pool->mutex);
+    }
+    SDL_UnlockMutex(pool->mutex);
+}
@@ -0,0 +1,23 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdint.h>
+
+typedef struct thread_pool* ThreadPool;
+typedef void (*ThreadPoolTask)(void*);
+
+// thread_count includes the thread calling thread_pool_wait, which executes
+// queued tasks alongside the workers. A thread_count of 0 uses one thread per
+// logical cpu and a thread_count of 1 spawns no workers at all.
+//
+// Tasks are spread over per-thread deques and idle threads steal from the
+// others, so submitting many small tasks keeps every thread busy.
+ThreadPool thread_pool_create(uint32_t thread_count);
+void       thread_pool_destroy(ThreadPool);
+uint32_t   thread_pool_thread_count(ThreadPool);
+void       thread_pool_submit(ThreadPool, ThreadPoolTask, void* arg);
+
+// blocks until every task submitted so far has finished
+void thread_pool_wait(ThreadPool);
+
+#endif  // THREAD_POOL_H
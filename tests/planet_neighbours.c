@@ -0,0 +1,134 @@
+// checks the neighbours height meshes list for every vertex, which
+// shaders/planet_heights.vert rebuilds the normals from: consecutive ones must
+// span a triangle of the mesh that is counter clockwise seen from outside, and
+// the fan must cover every triangle around the vertex
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#include "../src/planet.h"
+
+#define MESH_TIMEOUT_MS 60000
+
+// n = 1 is nothing but cube corners, 2 adds edge and face centre vertices and
+// 7 is a small odd grid
+static const uint32_t SUBDIVISIONS[] = {1, 2, 7};
+
+// waits for the mesh with n subdivisions, returns false on timeout
+static bool
+wait_for_mesh(Planet planet, uint32_t n, struct planet_mesh* mesh)
+{
+    const size_t index_count = (size_t)n * n * 6 * 6;
+    for (uint32_t waited = 0; waited < MESH_TIMEOUT_MS; waited++) {
+        *mesh = planet_acquire_mesh(planet);
+        if (mesh->index_count == index_count) return true;
+        SDL_Delay(1);
+    }
+    return false;
+}
+
+static struct vec3
+direction(const struct planet_mesh* mesh, uint32_t vertex)
+{
+    return (struct vec3){
+        mesh->directions.x[vertex],
+        mesh->directions.y[vertex],
+        mesh->directions.z[vertex],
+    };
+}
+
+// how many of the mesh's triangles have all of a, b and c as corners, or
+// just a if b and c are both a
+static uint32_t
+count_triangles(
+    const struct planet_mesh* mesh, uint32_t a, uint32_t b, uint32_t c
+)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < mesh->index_count; i += 3) {
+        const uint32_t* triangle = mesh->indices + i;
+        bool            has[3]   = {false, false, false};
+        for (int corner = 0; corner < 3; corner++) {
+            has[0] |= triangle[corner] == a;
+            has[1] |= triangle[corner] == b;
+            has[2] |= triangle[corner] == c;
+        }
+        if (has[0] && has[1] && has[2]) count++;
+    }
+    return count;
+}
+
+static bool
+check_neighbours(uint32_t n)
+{
+    Planet planet = planet_create(n + 1, 4);
+    planet_set_subdivisions(planet, n);
+
+    struct planet_mesh mesh;
+    if (!wait_for_mesh(planet, n, &mesh)) {
+        fprintf(stderr, "ERROR: no mesh with %u subdivisions\n", n);
+        planet_destroy(planet);
+        return false;
+    }
+
+    size_t failures = 0;
+    for (uint32_t vertex = 0; vertex < mesh.vertex_count; vertex++) {
+        const uint32_t* neighbours =
+            mesh.neighbours + (size_t)vertex * PLANET_MAX_NEIGHBOURS;
+
+        // repeats of the last neighbour only pad the list
+        uint32_t count = PLANET_MAX_NEIGHBOURS;
+        while (count > 1 && neighbours[count - 1] == neighbours[count - 2]) {
+            count--;
+        }
+
+        bool valid = count >= 3 &&
+                     count == count_triangles(&mesh, vertex, vertex, vertex);
+        const struct vec3 center = direction(&mesh, vertex);
+        for (uint32_t i = 0; valid && i < count; i++) {
+            uint32_t a = neighbours[i];
+            uint32_t b = neighbours[(i + 1) % count];
+            if (a >= mesh.vertex_count || b >= mesh.vertex_count ||
+                count_triangles(&mesh, vertex, a, b) != 1) {
+                valid = false;
+                break;
+            }
+            struct vec3 normal = vec3cross(
+                vec3sub(direction(&mesh, a), center),
+                vec3sub(direction(&mesh, b), center)
+            );
+            valid = vec3dot(normal, center) > 0.0f;
+        }
+        if (valid) continue;
+
+        if (failures++ < 10) {
+            fprintf(stderr, "ERROR: n=%u vertex %u has neighbours", n, vertex);
+            for (uint32_t i = 0; i < PLANET_MAX_NEIGHBOURS; i++) {
+                fprintf(stderr, " %u", neighbours[i]);
+            }
+            fprintf(stderr, "\n");
+        }
+    }
+
+    printf(
+        "planet neighbours: n=%u %zu vertices, %zu bad fans\n",
+        n,
+        mesh.vertex_count,
+        failures
+    );
+
+    planet_release_mesh(planet);
+    planet_destroy(planet);
+    return failures == 0;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+    for (size_t i = 0; i < sizeof SUBDIVISIONS / sizeof *SUBDIVISIONS; i++) {
+        passed = check_neighbours(SUBDIVISIONS[i]) && passed;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
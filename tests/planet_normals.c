@@ -0,0 +1,123 @@
+// compares the triangle normals the generator gathers per vertex against the
+// area weighted normals of scattering every triangle's cross product onto its
+// corners, which is how they used to be built
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#include "../src/planet.h"
+
+// degrees, the two only differ in the order the cross products are summed
+#define MAX_ANGLE 0.01
+
+#define MESH_TIMEOUT_MS 60000
+
+#define PI 3.14159265358979323846
+
+// n = 1 and 2 are nearly all seam vertices, 7 is a small odd grid and 64 has
+// a preview build published ahead of it
+static const uint32_t SUBDIVISIONS[] = {1, 2, 7, 64};
+
+static double
+normal_angle(struct vec3 a, const double b[3])
+{
+    double cross[3] = {
+        a.y * b[2] - a.z * b[1],
+        a.z * b[0] - a.x * b[2],
+        a.x * b[1] - a.y * b[0],
+    };
+    double sine = sqrt(
+        cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]
+    );
+    double cosine = a.x * b[0] + a.y * b[1] + a.z * b[2];
+    return atan2(sine, cosine) * 180.0 / PI;
+}
+
+// waits for the mesh with n subdivisions, returns false on timeout
+static bool
+wait_for_mesh(Planet planet, uint32_t n, struct planet_mesh* mesh)
+{
+    const size_t index_count = (size_t)n * n * 6 * 6;
+    for (uint32_t waited = 0; waited < MESH_TIMEOUT_MS; waited++) {
+        *mesh = planet_acquire_mesh(planet);
+        if (mesh->index_count == index_count) return true;
+        SDL_Delay(1);
+    }
+    return false;
+}
+
+static bool
+check_normals(uint32_t n)
+{
+    // the normals are set before the subdivisions, so any mesh with n
+    // subdivisions was configured with triangle normals
+    Planet planet = planet_create(n + 1, 4);
+    planet_set_normals(planet, PLANET_NORMALS_TRIANGLES);
+    planet_set_subdivisions(planet, n);
+
+    struct planet_mesh mesh;
+    if (!wait_for_mesh(planet, n, &mesh)) {
+        fprintf(stderr, "ERROR: no mesh with %u subdivisions\n", n);
+        planet_destroy(planet);
+        return false;
+    }
+
+    double (*expected)[3] = calloc(mesh.vertex_count, sizeof *expected);
+    if (expected == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < mesh.index_count; i += 3) {
+        const uint32_t* triangle = mesh.indices + i;
+        struct vec3     a        = mesh.vertices[triangle[0]];
+        struct vec3     b        = mesh.vertices[triangle[1]];
+        struct vec3     c        = mesh.vertices[triangle[2]];
+        struct vec3     normal   = vec3cross(vec3sub(c, a), vec3sub(b, a));
+        for (int corner = 0; corner < 3; corner++) {
+            expected[triangle[corner]][0] += normal.x;
+            expected[triangle[corner]][1] += normal.y;
+            expected[triangle[corner]][2] += normal.z;
+        }
+    }
+
+    double max_angle = 0.0;
+    size_t worst     = 0;
+    for (size_t i = 0; i < mesh.vertex_count; i++) {
+        double angle = normal_angle(mesh.normals[i], expected[i]);
+        if (!(angle <= max_angle)) {
+            max_angle = angle;
+            worst     = i;
+        }
+    }
+
+    bool passed = max_angle <= MAX_ANGLE;
+    printf(
+        "planet normals: n=%u %zu vertices, max angle %.3g degrees at %zu\n",
+        n,
+        mesh.vertex_count,
+        max_angle,
+        worst
+    );
+    if (!passed) {
+        fprintf(
+            stderr, "ERROR: normals differ by more than %g degrees\n", MAX_ANGLE
+        );
+    }
+
+    free(expected);
+    planet_release_mesh(planet);
+    planet_destroy(planet);
+    return passed;
+}
+
+int
+main(void)
+{
+    bool passed = true;
+    for (size_t i = 0; i < sizeof SUBDIVISIONS / sizeof *SUBDIVISIONS; i++) {
+        passed = check_normals(SUBDIVISIONS[i]) && passed;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,153 @@
+// compares the analytic gradients of the double batch sampler against central
+// differences of simplex_sample3, analytic planet normals are built from them.
+//
+// OpenSimplex has tiny jumps in value, around 1e-5, where it switches between
+// the lattice points it sums over. Differences straddling one are meaningless,
+// they are spotted by their one sided halves disagreeing and skipped, as long
+// as there are only a handful of them.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../simplex/simplex.h"
+
+#define POINT_COUNT 10007
+#define COORDINATE_RANGE 100.0
+#define SEED_COUNT 4
+
+// the truncation error of the differences shrinks with the square of the step
+// and the rounding error grows as it shrinks, both stay far below the
+// tolerance at this step
+#define STEP 1e-5
+#define TOLERANCE 1e-6
+
+// one sided differences away from a jump agree to about STEP
+#define JUMP_THRESHOLD 1e-3
+#define MAX_JUMP_FRACTION 1e-3
+
+static uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// uniform in [-COORDINATE_RANGE, COORDINATE_RANGE]
+static double
+random_coordinate(uint64_t* state)
+{
+    double unit = (double)(next_random(state) >> 11) / (double)(1ull << 53);
+    return (unit * 2.0 - 1.0) * COORDINATE_RANGE;
+}
+
+int
+main(void)
+{
+    double* x   = malloc(sizeof(double) * POINT_COUNT);
+    double* y   = malloc(sizeof(double) * POINT_COUNT);
+    double* z   = malloc(sizeof(double) * POINT_COUNT);
+    double* out = malloc(sizeof(double) * POINT_COUNT);
+    double* gx  = malloc(sizeof(double) * POINT_COUNT);
+    double* gy  = malloc(sizeof(double) * POINT_COUNT);
+    double* gz  = malloc(sizeof(double) * POINT_COUNT);
+    if (!x || !y || !z || !out || !gx || !gy || !gz) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t state     = 0x2545f4914f6cdd1dull;
+    double   max_error = 0.0;
+    size_t   failures  = 0;
+    size_t   jumps     = 0;
+    for (int64_t seed = 0; seed < SEED_COUNT; seed++) {
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            x[i] = random_coordinate(&state);
+            y[i] = random_coordinate(&state);
+            z[i] = random_coordinate(&state);
+        }
+
+        SimplexContext simplex =
+            simplex_context_create_precision(seed, SIMPLEX_PRECISION_DOUBLE);
+        simplex_sample3_batch_gradient(
+            simplex, x, y, z, out, gx, gy, gz, POINT_COUNT
+        );
+
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            const double p[3]        = {x[i], y[i], z[i]};
+            const double analytic[3] = {gx[i], gy[i], gz[i]};
+            for (int axis = 0; axis < 3; axis++) {
+                double above[3] = {p[0], p[1], p[2]};
+                double below[3] = {p[0], p[1], p[2]};
+                above[axis] += STEP;
+                below[axis] -= STEP;
+                double center = simplex_sample3(simplex, p[0], p[1], p[2]);
+                double forward =
+                    (simplex_sample3(simplex, above[0], above[1], above[2]) -
+                     center) /
+                    STEP;
+                double backward =
+                    (center -
+                     simplex_sample3(simplex, below[0], below[1], below[2])) /
+                    STEP;
+                if (fabs(forward - backward) > JUMP_THRESHOLD) {
+                    jumps++;
+                    continue;
+                }
+                double difference = (forward + backward) / 2.0;
+
+                double error = fabs(analytic[axis] - difference);
+                if (error > max_error) max_error = error;
+                if (error <= TOLERANCE) continue;
+                if (failures++ < 10) {
+                    fprintf(
+                        stderr,
+                        "ERROR: seed %lld (%g, %g, %g) axis %d analytic %.9g "
+                        "difference %.9g\n",
+                        (long long)seed,
+                        p[0],
+                        p[1],
+                        p[2],
+                        axis,
+                        analytic[axis],
+                        difference
+                    );
+                }
+            }
+        }
+        simplex_context_destroy(simplex);
+    }
+
+    printf(
+        "simplex gradient: %d x %d points, max error %.3g (tolerance %g), "
+        "%zu jumps skipped\n",
+        SEED_COUNT,
+        POINT_COUNT,
+        max_error,
+        TOLERANCE,
+        jumps
+    );
+
+    free(x);
+    free(y);
+    free(z);
+    free(out);
+    free(gx);
+    free(gy);
+    free(gz);
+
+    if (failures) {
+        fprintf(
+            stderr, "ERROR: %zu derivatives exceed the tolerance\n", failures
+        );
+        return EXIT_FAILURE;
+    }
+    if (jumps > MAX_JUMP_FRACTION * SEED_COUNT * POINT_COUNT * 3) {
+        fprintf(stderr, "ERROR: %zu differences straddle a jump\n", jumps);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+// compares the float batch sampler against the double one over random points
+// within the range SIMPLEX_FLOAT_TOLERANCE is documented for
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../simplex/simplex.h"
+
+#define POINT_COUNT 100003
+#define COORDINATE_RANGE 100.0
+#define SEED_COUNT 4
+
+static uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// uniform in [-COORDINATE_RANGE, COORDINATE_RANGE], rounded to float so both
+// samplers see the same point
+static float
+random_coordinate(uint64_t* state)
+{
+    double unit = (double)(next_random(state) >> 11) / (double)(1ull << 53);
+    return (float)((unit * 2.0 - 1.0) * COORDINATE_RANGE);
+}
+
+int
+main(void)
+{
+    float*  xf = malloc(sizeof(float) * POINT_COUNT);
+    float*  yf = malloc(sizeof(float) * POINT_COUNT);
+    float*  zf = malloc(sizeof(float) * POINT_COUNT);
+    float*  of = malloc(sizeof(float) * POINT_COUNT);
+    double* xd = malloc(sizeof(double) * POINT_COUNT);
+    double* yd = malloc(sizeof(double) * POINT_COUNT);
+    double* zd = malloc(sizeof(double) * POINT_COUNT);
+    double* od = malloc(sizeof(double) * POINT_COUNT);
+    if (!xf || !yf || !zf || !of || !xd || !yd || !zd || !od) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t state     = 0x9e3779b97f4a7c15ull;
+    double   max_error = 0.0;
+    size_t   failures  = 0;
+    for (int64_t seed = 0; seed < SEED_COUNT; seed++) {
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            xf[i] = random_coordinate(&state);
+            yf[i] = random_coordinate(&state);
+            zf[i] = random_coordinate(&state);
+            xd[i] = xf[i];
+            yd[i] = yf[i];
+            zd[i] = zf[i];
+        }
+
+        SimplexContext single =
+            simplex_context_create_precision(seed, SIMPLEX_PRECISION_FLOAT);
+        SimplexContext reference =
+            simplex_context_create_precision(seed, SIMPLEX_PRECISION_DOUBLE);
+        simplex_sample3f_batch(single, xf, yf, zf, of, POINT_COUNT);
+        simplex_sample3_batch(reference, xd, yd, zd, od, POINT_COUNT);
+        simplex_context_destroy(single);
+        simplex_context_destroy(reference);
+
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            double error = fabs((double)of[i] - od[i]);
+            if (error > max_error) max_error = error;
+            if (error <= SIMPLEX_FLOAT_TOLERANCE) continue;
+            if (failures++ < 10) {
+                fprintf(
+                    stderr,
+                    "ERROR: seed %lld (%g, %g, %g) float %.9g double %.9g\n",
+                    (long long)seed,
+                    xd[i],
+                    yd[i],
+                    zd[i],
+                    (double)of[i],
+                    od[i]
+                );
+            }
+        }
+    }
+
+    printf(
+        "simplex precision: %d x %d points, max error %.3g (tolerance %g)\n",
+        SEED_COUNT,
+        POINT_COUNT,
+        max_error,
+        SIMPLEX_FLOAT_TOLERANCE
+    );
+
+    free(xf);
+    free(yf);
+    free(zf);
+    free(of);
+    free(xd);
+    free(yd);
+    free(zd);
+    free(od);
+
+    if (failures) {
+        fprintf(stderr, "ERROR: %zu points exceed the tolerance\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}